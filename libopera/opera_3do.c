@@ -121,6 +121,7 @@ opera_3do_init(opera_ext_interface_t callback_)
 void
 opera_3do_destroy()
 {
+  opera_madam_sync();
   opera_arm_destroy();
   opera_xbus_destroy();
 }
@@ -134,10 +135,16 @@ opera_3do_internal_frame(uint32_t  cycles_,
 {
   opera_clock_push_cycles(cycles_);
   if(opera_clock_dsp_queued())
-    io_interface(EXT_DSP_TRIGGER,NULL);
+    {
+      io_interface(EXT_DSP_TRIGGER,NULL);
+      opera_arm_idle_event();
+    }
 
   if(opera_clock_timer_queued())
-    opera_clio_timer_execute();
+    {
+      opera_clio_timer_execute();
+      opera_arm_idle_event();
+    }
 
   if(opera_clock_vdl_queued())
     {
@@ -151,6 +158,7 @@ opera_3do_internal_frame(uint32_t  cycles_,
         opera_clio_fiq_generate(1<<1,0);
 
       (*line_)++;
+      opera_arm_idle_event();
     }
 }
 
@@ -158,6 +166,9 @@ void
 opera_3do_process_frame(void)
 {
   int32_t cnt;
+  int32_t used;
+  int32_t until;
+  int32_t budget;
   uint32_t line;
   uint32_t scanlines;
   static int field = 0;
@@ -165,25 +176,53 @@ opera_3do_process_frame(void)
   if(flagtime)
     flagtime--;
 
+  /* input and the frontend may have changed anything since last frame */
+  opera_arm_idle_break();
+
+  /* MADAM statistics are per frame */
+  opera_madam_stats_reset();
+
   cnt  = 0;
   line = 0;
   scanlines = opera_region_scanlines();
   do
     {
-      if(opera_madam_fsm_get() == FSM_INPROCESS)
+      if((opera_madam_fsm_get() == FSM_INPROCESS) && !opera_madam_cel_held())
+        opera_madam_cel_handle();
+
+      /* the CPU runs up to the next DSP, VDL or timer event */
+      until  = (int32_t)opera_clock_cycles_until_event();
+      budget = (until - cnt);
+      if(budget < 1)
+        budget = 1;
+
+      /* the cel engine holds the CPU off but for FIQs */
+      if(opera_madam_cel_held())
+        {
+          if(opera_arm_fiq_busy())
+            used = opera_arm_run(1);
+          else
+            used = opera_madam_cel_hold(budget);
+        }
+      else
         {
-          opera_madam_cel_handle();
-          opera_madam_fsm_set(FSM_IDLE);
+          /* an idle CPU is replayed up to the event */
+          used = opera_arm_idle_skip(budget);
+          if(used == 0)
+            used = opera_arm_run(budget);
         }
 
-      cnt += opera_arm_execute();
-      if(cnt >= 32)
+      cnt += used;
+      if(cnt >= until)
         {
           opera_3do_internal_frame(cnt,&line,field);
-          cnt -= 32;
+          cnt = 0;
         }
     } while(line < scanlines);
 
+  /* the frontend and save states see the whole frame */
+  opera_madam_sync();
+
   field = !field;
 }
 
@@ -215,6 +254,8 @@ opera_3do_state_save(void *buf_)
   data    = buf_;
   indexes = buf_;
 
+  opera_madam_sync();
+
   indexes[0] = 0x97970101;
   indexes[1] = 16 * 4;
   indexes[2] = indexes[1] + opera_arm_state_size();
@@ -248,6 +289,8 @@ opera_3do_state_load(const void *buf_)
   if(indexes[0] != 0x97970101)
     return 0;
 
+  opera_madam_sync();
+
   opera_arm_state_load(&data[indexes[1]]);
   opera_vdlp_state_load(&data[indexes[2]]);
   opera_dsp_state_load(&data[indexes[3]]);
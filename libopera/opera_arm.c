@@ -42,6 +42,7 @@
 #include "opera_sport.h"
 #include "opera_swi_hle_0x5XXXX.h"
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -118,6 +119,137 @@ const static uint16_t cond_flags_cross[]=
 static int        g_SWI_HLE;
 static arm_core_t CPU;
 static int        CYCLES;	//cycle counter
+static int        g_RUN_BREAK;  /* leave opera_arm_run() early */
+
+/*
+  Predecoded instruction cache
+
+  Every word the core executes out of DRAM or ROM is decoded once into
+  an arm_op_t holding the handler for its instruction class and the
+  operand fields that would otherwise be extracted from the opcode on
+  every pass. Pages of op records are allocated the first time code
+  runs from them. Writes to DRAM drop the record of the word written
+  so self modifying code and freshly loaded overlays are decoded again.
+*/
+
+#define ARM_OP_PAGE_SHIFT  12
+#define ARM_OP_PAGE_OPS    ((1 << ARM_OP_PAGE_SHIFT) >> 2)
+#define ARM_OP_DRAM_PAGES  (RAM_SIZE >> ARM_OP_PAGE_SHIFT)
+#define ARM_OP_ROM_PAGES   (ROM1_SIZE >> ARM_OP_PAGE_SHIFT)
+
+typedef struct arm_op_s arm_op_t;
+typedef void (*arm_op_handler_t)(const arm_op_t *op_);
+typedef int32_t (*arm_block_t)(const int32_t budget_);
+
+struct arm_op_s
+{
+  arm_op_handler_t handler;
+  uint32_t         cmd;
+  uint32_t         imm;         /* rotated immediate, signed offset or branch delta */
+  uint8_t          opc;         /* ALU opcode and S bit */
+  uint8_t          rd;
+  uint8_t          rn;
+  uint8_t          rm;
+  uint8_t          rs;
+  uint8_t          shift;
+  uint8_t          shtype;
+  uint8_t          block_ops;   /* instructions covered by block */
+  arm_block_t      block;       /* dynarec entry point */
+};
+
+static arm_op_t  *g_OPS_DRAM[ARM_OP_DRAM_PAGES];
+static arm_op_t  *g_OPS_ROM1[ARM_OP_ROM_PAGES];
+static arm_op_t  *g_OPS_ROM2[ARM_OP_ROM_PAGES];
+static arm_op_t **g_OPS_ROM = g_OPS_ROM1;
+static arm_op_t   g_OP_UNCACHED;
+
+#define ARM_BUS_PAGE_SHIFT 16
+#define ARM_BUS_PAGE_SIZE  (1 << ARM_BUS_PAGE_SHIFT)
+#define ARM_BUS_PAGE_MASK  (ARM_BUS_PAGE_SIZE - 1)
+#define ARM_BUS_PAGES      (1 << (32 - ARM_BUS_PAGE_SHIFT))
+
+enum
+  {
+    ARM_BUS_IO_UNMAPPED,
+    ARM_BUS_IO_DRAM,
+    ARM_BUS_IO_ROM,
+    ARM_BUS_IO_MADAM,
+    ARM_BUS_IO_CLIO,
+    ARM_BUS_IO_SPORT,
+    ARM_BUS_IO_NVRAM,
+    ARM_BUS_IO_COUNT
+  };
+
+typedef struct arm_bus_io_s arm_bus_io_t;
+struct arm_bus_io_s
+{
+  uint32_t (*read32)(const uint32_t addr_);
+  void     (*write32)(const uint32_t addr_, const uint32_t val_);
+  uint32_t (*read8)(const uint32_t addr_);
+  void     (*write8)(const uint32_t addr_, const uint8_t val_);
+};
+
+static uint8_t *g_BUS_RD[ARM_BUS_PAGES];
+static uint8_t *g_BUS_WR[ARM_BUS_PAGES];
+static uint8_t  g_BUS_IO[ARM_BUS_PAGES];
+/* DRAM pages which are fenced or hold cached cel data */
+static uint64_t g_BUS_FENCE;
+static uint64_t g_BUS_WATCH;
+
+/*
+  Idle loop skipping
+
+  Titles and the OS idle task spin in short loops polling a RAM flag
+  or a CLIO register until the next interrupt. A loop is locked once
+  an iteration starting at its head ends there with the same register
+  state without storing to memory or reading a device with side
+  effects. Until the next clock event nothing it reads can change so
+  every following iteration is identical. The frame loop then replays
+  the recorded instruction lengths rather than executing them and the
+  CPU catches up with the replayed position before it runs again.
+*/
+
+#define ARM_IDLE_SPAN     64  /* longest backward branch of a candidate */
+#define ARM_IDLE_HITS     4   /* branches back to the head before recording */
+#define ARM_IDLE_BACKOFF  64  /* branches ignored after a failed recording */
+#define ARM_IDLE_RETRIES  2
+#define ARM_IDLE_MAX_OPS  32
+
+enum
+  {
+    ARM_IDLE_SEARCH,
+    ARM_IDLE_RECORD,
+    ARM_IDLE_LOCKED
+  };
+
+typedef struct arm_idle_s arm_idle_t;
+struct arm_idle_s
+{
+  int        state;
+  int        dirty;             /* store or side effect since the snapshot */
+  int        io;                /* the loop reads device registers */
+  int        hits;
+  int        fails;
+  uint32_t   head;
+  uint32_t   pos;               /* instructions executed since the head */
+  uint32_t   ahead;             /* instructions replayed but not executed */
+  uint32_t   ops;               /* instructions per iteration */
+  int32_t    period;            /* cycles per iteration */
+  int32_t    sum[ARM_IDLE_MAX_OPS + 1]; /* cycles from the head to each op */
+  uint32_t   carry_out;
+  arm_core_t regs;
+  uint64_t   locks;
+  uint64_t   skipped;
+};
+
+static int        g_IDLE_SKIP = FALSE;
+static arm_idle_t g_IDLE;
+
+#ifdef ARM_PROFILER
+#include "opera_arm_profiler.ic"
+#else
+#include "opera_arm_profiler_none.ic"
+#endif
 
 static uint32_t readusr(uint32_t rn);
 static void     loadusr(uint32_t rn, uint32_t val);
@@ -125,6 +257,15 @@ static uint32_t mreadb(uint32_t addr);
 static void     mwriteb(uint32_t addr, uint8_t val);
 static uint32_t mreadw(uint32_t addr);
 static void     mwritew(uint32_t addr,uint32_t val);
+static void     arm_decode_cache_flush(void);
+static void     arm_decode_cache_free(void);
+static void     arm_bus_build(void);
+static void     arm_bus_dram_build(void);
+static void     arm_bus_watch_write(const uint32_t addr_);
+static void     arm_bus_dram_code_page(const uint32_t addr_);
+static void     arm_idle_reset(void);
+static void     arm_decode_table_init(void);
+static void     arm_swi_hle_init(void);
 
 uint8_t*
 opera_arm_nvram_get(void)
@@ -160,6 +301,8 @@ opera_arm_rom1_byteswap_if_necessary(void)
   size = opera_arm_rom1_size();
 
   swap32_array_if_little_endian((uint32_t*)rom,(size / sizeof(uint32_t)));
+
+  arm_decode_cache_flush();
 }
 
 uint8_t*
@@ -184,6 +327,8 @@ opera_arm_rom2_byteswap_if_necessary(void)
   size = opera_arm_rom2_size();
 
   swap32_array_if_little_endian((uint32_t*)rom,(size / sizeof(uint32_t)));
+
+  arm_decode_cache_flush();
 }
 
 uint8_t*
@@ -229,12 +374,15 @@ void
 opera_arm_state_load(const void *buf_)
 {
   uint8_t i;
+  int     bank2;
   uint8_t *ram   = CPU.ram;
   uint8_t *rom1  = CPU.rom1;
   uint8_t *rom2  = CPU.rom2;
   uint8_t *nvram = CPU.nvram;
 
   memcpy(&CPU,buf_,sizeof(arm_core_t));
+  /* the saved pointers only tell which bank was selected */
+  bank2 = (CPU.rom == CPU.rom2);
   memcpy(ram,((uint8_t*)buf_)+sizeof(arm_core_t),RAM_SIZE);
   memcpy(rom1,((uint8_t*)buf_)+sizeof(arm_core_t)+RAM_SIZE,ROM1_SIZE);
   memcpy(nvram,((uint8_t*)buf_)+sizeof(arm_core_t)+RAM_SIZE+ROM1_SIZE,NVRAM_SIZE);
@@ -248,281 +396,78 @@ opera_arm_state_load(const void *buf_)
   CPU.rom1  = rom1;
   CPU.rom2  = rom2;
   CPU.nvram = nvram;
-}
+  CPU.rom   = (bank2 ? rom2 : rom1);
 
-static
-void
-ARM_RestUserRONS(void)
-{
-  switch(arm_mode_table[CPU.CPSR & 0x1F])
-    {
-    case ARM_MODE_USER:
-      break;
-    case ARM_MODE_FIQ:
-      memcpy(CPU.FIQ,&CPU.USER[8],7<<2);
-      memcpy(&CPU.USER[8],CPU.CASH,7<<2);
-      break;
-    case ARM_MODE_IRQ:
-      CPU.IRQ[0]   = CPU.USER[13];
-      CPU.IRQ[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.CASH[5];
-      CPU.USER[14] = CPU.CASH[6];
-      break;
-    case ARM_MODE_SVC:
-      CPU.SVC[0]   = CPU.USER[13];
-      CPU.SVC[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.CASH[5];
-      CPU.USER[14] = CPU.CASH[6];
-      break;
-    case ARM_MODE_ABT:
-      CPU.ABT[0]   = CPU.USER[13];
-      CPU.ABT[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.CASH[5];
-      CPU.USER[14] = CPU.CASH[6];
-      break;
-    case ARM_MODE_UND:
-      CPU.UND[0]   = CPU.USER[13];
-      CPU.UND[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.CASH[5];
-      CPU.USER[14] = CPU.CASH[6];
-      break;
-    }
+  g_OPS_ROM = (bank2 ? g_OPS_ROM2 : g_OPS_ROM1);
+  arm_decode_cache_flush();
+  arm_bus_build();
+  arm_idle_reset();
+  opera_madam_dram_dirty(0,RAM_SIZE);
 }
 
-static
-void
-ARM_RestFiqRONS(void)
-{
-  switch(arm_mode_table[CPU.CPSR & 0x1F])
-    {
-    case ARM_MODE_USER:
-      memcpy(CPU.CASH,&CPU.USER[8],7<<2);
-      memcpy(&CPU.USER[8],CPU.FIQ,7<<2);
-      break;
-    case ARM_MODE_FIQ:
-      break;
-    case ARM_MODE_IRQ:
-      memcpy(CPU.CASH,&CPU.USER[8],5<<2);
-      CPU.IRQ[0] = CPU.USER[13];
-      CPU.IRQ[1] = CPU.USER[14];
-      memcpy(&CPU.USER[8],CPU.FIQ,7<<2);
-      break;
-    case ARM_MODE_SVC:
-      memcpy(CPU.CASH,&CPU.USER[8],5<<2);
-      CPU.SVC[0] = CPU.USER[13];
-      CPU.SVC[1] = CPU.USER[14];
-      memcpy(&CPU.USER[8],CPU.FIQ,7<<2);
-      break;
-    case ARM_MODE_ABT:
-      memcpy(CPU.CASH,&CPU.USER[8],5<<2);
-      CPU.ABT[0] = CPU.USER[13];
-      CPU.ABT[1] = CPU.USER[14];
-      memcpy(&CPU.USER[8],CPU.FIQ,7<<2);
-      break;
-    case ARM_MODE_UND:
-      memcpy(CPU.CASH,&CPU.USER[8],5<<2);
-      CPU.UND[0] = CPU.USER[13];
-      CPU.UND[1] = CPU.USER[14];
-      memcpy(&CPU.USER[8],CPU.FIQ,7<<2);
-      break;
-    }
-}
+/*
+  Banked registers
+
+  The registers of the current mode always live in CPU.USER so the
+  instruction handlers and translated code address them directly.
+  Each mode points at the slots its r8-r12 and r13-r14 are kept in
+  while another mode runs. A mode change parks the outgoing registers
+  in their slots and loads the incoming ones, r8-r12 only move when
+  FIQ mode is involved. The slots are the arm_core_t arrays so
+  savestates are unchanged.
+*/
 
-static
-void
-ARM_RestIrqRONS(void)
-{
-  switch(arm_mode_table[CPU.CPSR & 0x1F])
-    {
-    case ARM_MODE_USER:
-      CPU.CASH[5]  = CPU.USER[13];
-      CPU.CASH[6]  = CPU.USER[14];
-      CPU.USER[13] = CPU.IRQ[0];
-      CPU.USER[14] = CPU.IRQ[1];
-      break;
-    case ARM_MODE_FIQ:
-      memcpy(CPU.FIQ,&CPU.USER[8],7<<2);
-      memcpy(&CPU.USER[8],CPU.CASH,5<<2);
-      CPU.USER[13] = CPU.IRQ[0];
-      CPU.USER[14] = CPU.IRQ[1];
-      break;
-    case ARM_MODE_IRQ:
-      break;
-    case ARM_MODE_SVC:
-      CPU.SVC[0]   = CPU.USER[13];
-      CPU.SVC[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.IRQ[0];
-      CPU.USER[14] = CPU.IRQ[1];
-      break;
-    case ARM_MODE_ABT:
-      CPU.ABT[0]   = CPU.USER[13];
-      CPU.ABT[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.IRQ[0];
-      CPU.USER[14] = CPU.IRQ[1];
-      break;
-    case ARM_MODE_UND:
-      CPU.UND[0]   = CPU.USER[13];
-      CPU.UND[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.IRQ[0];
-      CPU.USER[14] = CPU.IRQ[1];
-      break;
-    }
-}
+static uint32_t * const g_BANK_R8[] =
+  {
+    CPU.CASH,                   /* USER */
+    CPU.FIQ,                    /* FIQ */
+    CPU.CASH,                   /* IRQ */
+    CPU.CASH,                   /* SVC */
+    CPU.CASH,                   /* ABT */
+    CPU.CASH                    /* UND */
+  };
 
-static
-void
-ARM_RestSvcRONS(void)
-{
-  switch(arm_mode_table[CPU.CPSR & 0x1F])
-    {
-    case ARM_MODE_USER:
-      CPU.CASH[5]  = CPU.USER[13];
-      CPU.CASH[6]  = CPU.USER[14];
-      CPU.USER[13] = CPU.SVC[0];
-      CPU.USER[14] = CPU.SVC[1];
-      break;
-    case ARM_MODE_FIQ:
-      memcpy(CPU.FIQ,&CPU.USER[8],7<<2);
-      memcpy(&CPU.USER[8],CPU.CASH,5<<2);
-      CPU.USER[13] = CPU.SVC[0];
-      CPU.USER[14] = CPU.SVC[1];
-      break;
-    case ARM_MODE_IRQ:
-      CPU.IRQ[0]   = CPU.USER[13];
-      CPU.IRQ[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.SVC[0];
-      CPU.USER[14] = CPU.SVC[1];
-      break;
-    case ARM_MODE_SVC:
-      break;
-    case ARM_MODE_ABT:
-      CPU.ABT[0]   = CPU.USER[13];
-      CPU.ABT[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.SVC[0];
-      CPU.USER[14] = CPU.SVC[1];
-      break;
-    case ARM_MODE_UND:
-      CPU.UND[0]   = CPU.USER[13];
-      CPU.UND[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.SVC[0];
-      CPU.USER[14] = CPU.SVC[1];
-      break;
-    }
-}
+static uint32_t * const g_BANK_R13[] =
+  {
+    &CPU.CASH[5],               /* USER */
+    &CPU.FIQ[5],                /* FIQ */
+    CPU.IRQ,
+    CPU.SVC,
+    CPU.ABT,
+    CPU.UND
+  };
 
 static
 void
-ARM_RestAbtRONS(void)
+ARM_Change_ModeSafe(uint32_t mode_)
 {
-  switch(arm_mode_table[CPU.CPSR & 0x1F])
-    {
-    case ARM_MODE_USER:
-      CPU.CASH[5]  = CPU.USER[13];
-      CPU.CASH[6]  = CPU.USER[14];
-      CPU.USER[13] = CPU.ABT[0];
-      CPU.USER[14] = CPU.ABT[1];
-      break;
-    case ARM_MODE_FIQ:
-      memcpy(CPU.FIQ,&CPU.USER[8],7<<2);
-      memcpy(&CPU.USER[8],CPU.CASH,5<<2);
-      CPU.USER[13] = CPU.ABT[0];
-      CPU.USER[14] = CPU.ABT[1];
-      break;
-    case ARM_MODE_IRQ:
-      CPU.IRQ[0]   = CPU.USER[13];
-      CPU.IRQ[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.ABT[0];
-      CPU.USER[14] = CPU.ABT[1];
-      break;
-    case ARM_MODE_SVC:
-      CPU.SVC[0]   = CPU.USER[13];
-      CPU.SVC[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.ABT[0];
-      CPU.USER[14] = CPU.ABT[1];
-      break;
-    case ARM_MODE_ABT:
-      break;
-    case ARM_MODE_UND:
-      CPU.UND[0]   = CPU.USER[13];
-      CPU.UND[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.ABT[0];
-      CPU.USER[14] = CPU.ABT[1];
-      break;
-    }
-}
+  uint8_t cur;
+  uint8_t next;
 
-static
-void
-ARM_RestUndRONS(void)
-{
-  switch(arm_mode_table[CPU.CPSR & 0x1F])
-    {
-    case ARM_MODE_USER:
-      CPU.CASH[5]  = CPU.USER[13];
-      CPU.CASH[6]  = CPU.USER[14];
-      CPU.USER[13] = CPU.UND[0];
-      CPU.USER[14] = CPU.UND[1];
-      break;
-    case ARM_MODE_FIQ:
-      memcpy(CPU.FIQ,&CPU.USER[8],7<<2);
-      memcpy(&CPU.USER[8],CPU.CASH,5<<2);
-      CPU.USER[13] = CPU.UND[0];
-      CPU.USER[14] = CPU.UND[1];
-      break;
-    case ARM_MODE_IRQ:
-      CPU.IRQ[0]   = CPU.USER[13];
-      CPU.IRQ[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.UND[0];
-      CPU.USER[14] = CPU.UND[1];
-      break;
-    case ARM_MODE_SVC:
-      CPU.SVC[0]   = CPU.USER[13];
-      CPU.SVC[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.UND[0];
-      CPU.USER[14] = CPU.UND[1];
-      break;
-    case ARM_MODE_ABT:
-      CPU.ABT[0]   = CPU.USER[13];
-      CPU.ABT[1]   = CPU.USER[14];
-      CPU.USER[13] = CPU.UND[0];
-      CPU.USER[14] = CPU.UND[1];
-      break;
-    case ARM_MODE_UND:
-      break;
-    }
-}
+  cur  = arm_mode_table[CPU.CPSR & 0x1F];
+  next = arm_mode_table[mode_ & 0x1F];
+  if((cur == next) || (cur == ARM_MODE_UNK) || (next == ARM_MODE_UNK))
+    return;
 
-static
-void
-ARM_Change_ModeSafe(uint32_t mode_)
-{
-  switch(arm_mode_table[mode_ & 0x1F])
+  if(g_BANK_R8[cur] != g_BANK_R8[next])
     {
-    case ARM_MODE_USER:
-      ARM_RestUserRONS();
-      break;
-    case ARM_MODE_FIQ:
-      ARM_RestFiqRONS();
-      break;
-    case ARM_MODE_IRQ:
-      ARM_RestIrqRONS();
-      break;
-    case ARM_MODE_SVC:
-      ARM_RestSvcRONS();
-      break;
-    case ARM_MODE_ABT:
-      ARM_RestAbtRONS();
-      break;
-    case ARM_MODE_UND:
-      ARM_RestUndRONS();
-      break;
+      memcpy(g_BANK_R8[cur],&CPU.USER[8],5<<2);
+      memcpy(&CPU.USER[8],g_BANK_R8[next],5<<2);
     }
+
+  g_BANK_R13[cur][0] = CPU.USER[13];
+  g_BANK_R13[cur][1] = CPU.USER[14];
+  CPU.USER[13] = g_BANK_R13[next][0];
+  CPU.USER[14] = g_BANK_R13[next][1];
 }
 
 void
 opera_arm_rom_select(int n_)
 {
-  CPU.rom = ((n_ == 0) ? CPU.rom1 : CPU.rom2);
+  CPU.rom   = ((n_ == 0) ? CPU.rom1 : CPU.rom2);
+  g_OPS_ROM = ((n_ == 0) ? g_OPS_ROM1 : g_OPS_ROM2);
+  arm_bus_build();
+  arm_idle_reset();
 }
 
 static
@@ -619,6 +564,9 @@ opera_arm_init(void)
   int i;
 
   g_SWI_HLE = 0;
+  arm_swi_hle_init();
+
+  arm_decode_table_init();
 
   CYCLES = 0;
   for(i = 0; i < 16; i++)
@@ -641,11 +589,16 @@ opera_arm_init(void)
   CPU.rom   = CPU.rom1;
   CPU.nvram = calloc(NVRAM_SIZE,1);
 
+  g_OPS_ROM = g_OPS_ROM1;
+
   CPU.nFIQ = FALSE;
   CPU.MAS_Access_Exept = FALSE;
 
   CPU.USER[15] = ARM_INITIAL_PC;
   arm_cpsr_set(0x13);
+
+  arm_bus_build();
+  arm_idle_reset();
 }
 
 void
@@ -666,6 +619,9 @@ opera_arm_destroy(void)
   if(CPU.ram)
     free(CPU.ram);
   CPU.ram = NULL;
+
+  arm_decode_cache_free();
+  arm_bus_build();
 }
 
 void
@@ -674,7 +630,8 @@ opera_arm_reset(void)
   int i;
 
   CYCLES = 0;
-  CPU.rom = CPU.rom1;
+  CPU.rom   = CPU.rom1;
+  g_OPS_ROM = g_OPS_ROM1;
 
   for(i = 0; i < 16; i++)
     CPU.USER[i] = 0;
@@ -696,6 +653,8 @@ opera_arm_reset(void)
 
   CPU.USER[15] = ARM_INITIAL_PC;
   arm_cpsr_set(0x13);
+  arm_bus_build();
+  arm_idle_reset();
 
   opera_clio_reset();
   opera_madam_reset();
@@ -971,150 +930,420 @@ decode_swi_lle(void)
   CPU.USER[15] = 0x00000008;
 }
 
-static void decode_swi_hle(const uint32_t op_)
-{
-  switch(op_ & 0x000FFFFF)
-    {
-    case 0x50000:
-      opera_swi_hle_0x50000(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2]);
-      return;
-    case 0x50001:
-      opera_swi_hle_0x50001(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2]);
-      return;
-    case 0x50002:
-      opera_swi_hle_0x50002(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2],CPU.USER[3]);
-      return;
-    case 0x50003:
-      break;
-    case 0x50004:
-      break;
-    case 0x50005:
-      opera_swi_hle_0x50005(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2],CPU.USER[3]);
-      return;
-    case 0x50006:
-      opera_swi_hle_0x50006(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2],CPU.USER[3]);
-      return;
-    case 0x50007:
-      opera_swi_hle_0x50007(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2]);
-      return;
-    case 0x50008:
-      opera_swi_hle_0x50008(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2]);
-      return;
-    case 0x50009:
-      opera_swi_hle_0x50009(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2],CPU.USER[3]);
-      return;
-    case 0x5000A:
-      break;
-    case 0x5000B:
-      break;
-    case 0x5000C:
-      CPU.USER[0] = opera_swi_hle_0x5000C(CPU.ram,CPU.USER[0],CPU.USER[1]);
-      return;
-    case 0x5000E:
-      opera_swi_hle_0x5000E(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2]);
-      return;
-    case 0x5000F:
-      CPU.USER[0] = opera_swi_hle_0x5000F(CPU.ram,CPU.USER[0]);
-      return;
-    case 0x50010:
-      CPU.USER[0] = opera_swi_hle_0x50010(CPU.ram,CPU.USER[0]);
-      return;
-    case 0x50011:
-      opera_swi_hle_0x50011(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2],CPU.USER[3]);
-      return;
-    case 0x50012:
-      opera_swi_hle_0x50012(CPU.ram,CPU.USER[0]);
-      return;
-    }
+/*
+  SWI HLE
 
-  decode_swi_lle();
-}
+  Calls with a high level implementation are registered in
+  g_SWI_HLE_CALLS and found by SWI number through g_SWI_HLE_INDEX,
+  built once at init, so adding one takes a wrapper and a table entry.
+  The index packs the folio number into bits 11:8 and the call number
+  into bits 7:0.
+*/
 
-static void decode_swi(const uint32_t op_)
-{
-  CYCLES -= (SCYCLE + NCYCLE);  // +2S+1N
+#define ARM_SWI_HLE_SLOTS  0x1000
+#define ARM_SWI_HLE_INDEX(swi_) ((((swi_) >> 8) & 0xF00) | ((swi_) & 0xFF))
 
-  if(g_SWI_HLE)
-  {
-    decode_swi_hle(op_);
-    return;
-  }
+#define ARM_SWI_ARGS1 (CPU.ram,CPU.USER[0])
+#define ARM_SWI_ARGS2 (CPU.ram,CPU.USER[0],CPU.USER[1])
+#define ARM_SWI_ARGS3 (CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2])
+#define ARM_SWI_ARGS4 (CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2],CPU.USER[3])
 
-  decode_swi_lle();
-}
+/*
+  The calls read and write DRAM directly, past any fence, so each also
+  reports the guest memory it uses: slot 0 is what it writes, the rest
+  what it reads. Only those ranges are waited on before the call and
+  only the written one is dirtied after it. The object calls write
+  through pointers found in the objects and report all of DRAM.
+*/
 
+#define ARM_SWI_HLE_MEM_SLOTS 3
 
-static uint32_t carry_out = 0;
+#define ARM_SWI_MEM(N,ADDR,LEN) mem_[N].addr = (ADDR); mem_[N].len = (LEN);
+#define ARM_SWI_MEM_ALL         ARM_SWI_MEM(0,0,RAM_SIZE)
+#define ARM_SWI_MEM_R(N,R,LEN)  ARM_SWI_MEM(N,CPU.USER[R],LEN)
+#define ARM_SWI_MEM_N(N,R,SIZE) ARM_SWI_MEM(N,CPU.USER[R],arm_swi_mem_len(CPU.USER[3],SIZE))
 
-static
-INLINE
-void
-ARM_SET_C(const uint32_t x_)
+typedef struct arm_swi_mem_s arm_swi_mem_t;
+struct arm_swi_mem_s
 {
-  CPU.CPSR = ((CPU.CPSR & 0xdfffffff) | ((x_ & 1) << 29));
-}
+  uint32_t addr;
+  uint32_t len;
+};
 
 static
 INLINE
-void
-ARM_SET_Z(const uint32_t x_)
+uint32_t
+arm_swi_mem_len(const uint32_t count_,
+                const uint32_t size_)
 {
-  CPU.CPSR = ((CPU.CPSR & 0xbfffffff) | (x_ == 0 ? 0x40000000 : 0));
+  if((int32_t)count_ <= 0)
+    return 0;
+  if(count_ >= (RAM_SIZE / size_))
+    return RAM_SIZE;
+
+  return (count_ * size_);
 }
 
+/*
+  MulManyVec3Mat33DivZ takes its arguments in a struct at R0 which has
+  to be current before the pointers in it are read. Its count is
+  unsigned.
+*/
 static
-INLINE
 void
-ARM_SET_N(const uint32_t x_)
+arm_swi_mem_mmv3m33d(arm_swi_mem_t *mem_)
 {
-  CPU.CPSR = ((CPU.CPSR & 0x7fffffff) | (x_ & 0x80000000));
+  uint32_t  s;
+  uint32_t  len;
+  uint32_t *args;
+
+  s = CPU.USER[0];
+  opera_madam_sync_range(s,0x14);
+  if(s > (RAM_SIZE - 0x14))
+    {
+      ARM_SWI_MEM_ALL
+      return;
+    }
+
+  args = (uint32_t*)&CPU.ram[s];
+  len  = ((args[4] >= (RAM_SIZE / sizeof(vec3f16))) ?
+          RAM_SIZE : (args[4] * sizeof(vec3f16)));
+
+  ARM_SWI_MEM(0,args[0],len)
+  ARM_SWI_MEM(1,args[1],len)
+  ARM_SWI_MEM(2,args[2],sizeof(mat33f16))
 }
 
+/*
+  What a call wrote may hold code the CPU has predecoded or
+  translated, it's invalidated once the call returns. Slot 0 covers
+  it but for the object calls, whose slot 0 is all of DRAM. They walk
+  the list again and invalidate each object's destination instead.
+*/
 static
 INLINE
 uint32_t
-ARM_GET_C(void)
+arm_swi_ram_word(const uint32_t addr_)
 {
-  return ((CPU.CPSR >> 29) & 1);
-}
+  if(addr_ > (RAM_SIZE - sizeof(uint32_t)))
+    return 0;
 
-static
-INLINE
-void
-ARM_SET_ZN(const uint32_t val_)
-{
-  if(val_)
-    CPU.CPSR = ((CPU.CPSR & 0x3fffffff) | (val_ & 0x80000000));
-  else
-    CPU.CPSR = ((CPU.CPSR & 0x3fffffff) | 0x40000000);
+  return *(const uint32_t*)&CPU.ram[addr_];
 }
 
 static
-INLINE
 void
-ARM_SET_CV(const uint32_t rd_,
-           const uint32_t op1_,
-           const uint32_t op2_)
+arm_swi_invalidate_obj_arrays(const uint32_t size_)
 {
-  CPU.CPSR = ((CPU.CPSR & 0xcfffffff) |
-              ((((op1_ & op2_) | ((~rd_) & (op1_ | op2_))) & 0x80000000) >> 2) |
-              (((((op1_ & (op2_ & (~rd_))) | ((~op1_) & (~op2_) & rd_))) & 0x80000000) >> 3));
+  int32_t  i;
+  uint32_t obj;
+  int32_t  dest;
+  int32_t  count;
+
+  dest  = arm_swi_ram_word(CPU.USER[1] + offsetof(ObjOffset1,oo1_DestArrayPtrOffset));
+  count = arm_swi_ram_word(CPU.USER[1] + offsetof(ObjOffset1,oo1_CountOffset));
+  for(i = 0; i < (int32_t)CPU.USER[2]; i++)
+    {
+      obj = arm_swi_ram_word(CPU.USER[0] + (i * sizeof(uint32_t)));
+      opera_arm_decode_cache_invalidate(arm_swi_ram_word(obj + dest),
+                                        arm_swi_mem_len(arm_swi_ram_word(obj + count),size_));
+    }
 }
 
 static
-INLINE
 void
-ARM_SET_CV_sub(uint32_t rd_,
-               uint32_t op1_,
-               uint32_t op2_)
+arm_swi_invalidate_obj_mats(const uint32_t size_)
 {
-  CPU.CPSR = ((CPU.CPSR & 0xcfffffff) |
-              ((((op1_ & (~op2_)) | ((~rd_) & (op1_ | (~op2_)))) & 0x80000000) >> 2) |
-              (((((op1_ & ((~op2_) & (~rd_))) | ((~op1_) & op2_ & rd_))) & 0x80000000) >> 3));
+  int32_t  i;
+  uint32_t obj;
+  int32_t  dest;
+
+  dest = arm_swi_ram_word(CPU.USER[1] + offsetof(ObjOffset2,oo2_DestMatOffset));
+  for(i = 0; i < (int32_t)CPU.USER[3]; i++)
+    {
+      obj = arm_swi_ram_word(CPU.USER[0] + (i * sizeof(uint32_t)));
+      opera_arm_decode_cache_invalidate(obj + dest,size_);
+    }
+}
+
+static void arm_swi_invalidate_0x50003(void) { arm_swi_invalidate_obj_arrays(sizeof(vec3f16)); }
+static void arm_swi_invalidate_0x50004(void) { arm_swi_invalidate_obj_mats(sizeof(mat33f16));  }
+static void arm_swi_invalidate_0x5000A(void) { arm_swi_invalidate_obj_arrays(sizeof(vec4f16)); }
+static void arm_swi_invalidate_0x5000B(void) { arm_swi_invalidate_obj_mats(sizeof(mat44f16));  }
+
+#define ARM_SWI_HLE(SWI,ARGS,MEM)                               \
+  static void arm_swi_hle_##SWI(void)                           \
+  {                                                             \
+    opera_swi_hle_##SWI ARGS;                                   \
+  }                                                             \
+  static void arm_swi_hle_mem_##SWI(arm_swi_mem_t *mem_)        \
+  {                                                             \
+    MEM                                                         \
+  }
+
+#define ARM_SWI_HLE_R0(SWI,ARGS,MEM)                            \
+  static void arm_swi_hle_##SWI(void)                           \
+  {                                                             \
+    CPU.USER[0] = opera_swi_hle_##SWI ARGS;                     \
+  }                                                             \
+  static void arm_swi_hle_mem_##SWI(arm_swi_mem_t *mem_)        \
+  {                                                             \
+    MEM                                                         \
+  }
+
+ARM_SWI_HLE(0x50000,ARM_SWI_ARGS3,
+            ARM_SWI_MEM_R(0,0,sizeof(vec3f16))
+            ARM_SWI_MEM_R(1,1,sizeof(vec3f16))
+            ARM_SWI_MEM_R(2,2,sizeof(mat33f16)))
+ARM_SWI_HLE(0x50001,ARM_SWI_ARGS3,
+            ARM_SWI_MEM_R(0,0,sizeof(mat33f16))
+            ARM_SWI_MEM_R(1,1,sizeof(mat33f16))
+            ARM_SWI_MEM_R(2,2,sizeof(mat33f16)))
+ARM_SWI_HLE(0x50002,ARM_SWI_ARGS4,
+            ARM_SWI_MEM_N(0,0,sizeof(vec3f16))
+            ARM_SWI_MEM_N(1,1,sizeof(vec3f16))
+            ARM_SWI_MEM_R(2,2,sizeof(mat33f16)))
+ARM_SWI_HLE(0x50003,ARM_SWI_ARGS3,
+            ARM_SWI_MEM_ALL)
+ARM_SWI_HLE(0x50004,ARM_SWI_ARGS4,
+            ARM_SWI_MEM_ALL)
+ARM_SWI_HLE(0x50005,ARM_SWI_ARGS4,
+            ARM_SWI_MEM_N(0,0,sizeof(frac16))
+            ARM_SWI_MEM_N(1,1,sizeof(frac16))
+            ARM_SWI_MEM_N(2,2,sizeof(frac16)))
+ARM_SWI_HLE(0x50006,ARM_SWI_ARGS4,
+            ARM_SWI_MEM_N(0,0,sizeof(frac16))
+            ARM_SWI_MEM_N(1,1,sizeof(frac16)))
+ARM_SWI_HLE(0x50007,ARM_SWI_ARGS3,
+            ARM_SWI_MEM_R(0,0,sizeof(vec4f16))
+            ARM_SWI_MEM_R(1,1,sizeof(vec4f16))
+            ARM_SWI_MEM_R(2,2,sizeof(mat44f16)))
+ARM_SWI_HLE(0x50008,ARM_SWI_ARGS3,
+            ARM_SWI_MEM_R(0,0,sizeof(mat44f16))
+            ARM_SWI_MEM_R(1,1,sizeof(mat44f16))
+            ARM_SWI_MEM_R(2,2,sizeof(mat44f16)))
+ARM_SWI_HLE(0x50009,ARM_SWI_ARGS4,
+            ARM_SWI_MEM_N(0,0,sizeof(vec4f16))
+            ARM_SWI_MEM_N(1,1,sizeof(vec4f16))
+            ARM_SWI_MEM_R(2,2,sizeof(mat44f16)))
+ARM_SWI_HLE(0x5000A,ARM_SWI_ARGS3,
+            ARM_SWI_MEM_ALL)
+ARM_SWI_HLE(0x5000B,ARM_SWI_ARGS4,
+            ARM_SWI_MEM_ALL)
+ARM_SWI_HLE_R0(0x5000C,ARM_SWI_ARGS2,
+               ARM_SWI_MEM_R(1,0,sizeof(vec3f16))
+               ARM_SWI_MEM_R(2,1,sizeof(vec3f16)))
+ARM_SWI_HLE_R0(0x5000D,ARM_SWI_ARGS2,
+               ARM_SWI_MEM_R(1,0,sizeof(vec4f16))
+               ARM_SWI_MEM_R(2,1,sizeof(vec4f16)))
+ARM_SWI_HLE(0x5000E,ARM_SWI_ARGS3,
+            ARM_SWI_MEM_R(0,0,sizeof(vec3f16))
+            ARM_SWI_MEM_R(1,1,sizeof(vec3f16))
+            ARM_SWI_MEM_R(2,2,sizeof(vec3f16)))
+ARM_SWI_HLE_R0(0x5000F,ARM_SWI_ARGS1,
+               ARM_SWI_MEM_R(1,0,sizeof(vec3f16)))
+ARM_SWI_HLE_R0(0x50010,ARM_SWI_ARGS1,
+               ARM_SWI_MEM_R(1,0,sizeof(vec4f16)))
+ARM_SWI_HLE(0x50011,ARM_SWI_ARGS4,
+            ARM_SWI_MEM_R(0,0,sizeof(vec3f16))
+            ARM_SWI_MEM_R(1,1,sizeof(vec3f16))
+            ARM_SWI_MEM_R(2,2,sizeof(mat33f16)))
+ARM_SWI_HLE(0x50012,ARM_SWI_ARGS1,
+            arm_swi_mem_mmv3m33d(mem_);)
+
+typedef struct arm_swi_hle_s arm_swi_hle_t;
+struct arm_swi_hle_s
+{
+  uint32_t   swi;
+  void     (*func)(void);
+  void     (*mem)(arm_swi_mem_t *mem_);
+  void     (*invalidate)(void);
+  uint64_t   hits;
+};
+
+#define ARM_SWI_HLE_CALL(SWI)     { SWI, arm_swi_hle_##SWI, arm_swi_hle_mem_##SWI, NULL, 0 }
+#define ARM_SWI_HLE_OBJ_CALL(SWI) { SWI, arm_swi_hle_##SWI, arm_swi_hle_mem_##SWI, arm_swi_invalidate_##SWI, 0 }
+
+static arm_swi_hle_t g_SWI_HLE_CALLS[] =
+  {
+    ARM_SWI_HLE_CALL(0x50000),
+    ARM_SWI_HLE_CALL(0x50001),
+    ARM_SWI_HLE_CALL(0x50002),
+    ARM_SWI_HLE_OBJ_CALL(0x50003),
+    ARM_SWI_HLE_OBJ_CALL(0x50004),
+    ARM_SWI_HLE_CALL(0x50005),
+    ARM_SWI_HLE_CALL(0x50006),
+    ARM_SWI_HLE_CALL(0x50007),
+    ARM_SWI_HLE_CALL(0x50008),
+    ARM_SWI_HLE_CALL(0x50009),
+    ARM_SWI_HLE_OBJ_CALL(0x5000A),
+    ARM_SWI_HLE_OBJ_CALL(0x5000B),
+    ARM_SWI_HLE_CALL(0x5000C),
+    ARM_SWI_HLE_CALL(0x5000D),
+    ARM_SWI_HLE_CALL(0x5000E),
+    ARM_SWI_HLE_CALL(0x5000F),
+    ARM_SWI_HLE_CALL(0x50010),
+    ARM_SWI_HLE_CALL(0x50011),
+    ARM_SWI_HLE_CALL(0x50012)
+  };
+
+#define ARM_SWI_HLE_CALLS (sizeof(g_SWI_HLE_CALLS) / sizeof(g_SWI_HLE_CALLS[0]))
+
+static arm_swi_hle_t *g_SWI_HLE_INDEX[ARM_SWI_HLE_SLOTS];
+
+static
+void
+arm_swi_hle_init(void)
+{
+  uint32_t i;
+  uint32_t swi;
+
+  opera_fixedpoint_math_init(1);
+
+  memset(g_SWI_HLE_INDEX,0,sizeof(g_SWI_HLE_INDEX));
+  for(i = 0; i < ARM_SWI_HLE_CALLS; i++)
+    {
+      swi = g_SWI_HLE_CALLS[i].swi;
+      g_SWI_HLE_CALLS[i].hits = 0;
+      g_SWI_HLE_INDEX[ARM_SWI_HLE_INDEX(swi)] = &g_SWI_HLE_CALLS[i];
+    }
+}
+
+/*
+  Number and hits of the n_th registered HLE call. Returns 0 once n_
+  is past the last one.
+*/
+int
+opera_arm_swi_hle_stats(const uint32_t  n_,
+                        uint32_t       *swi_,
+                        uint64_t       *hits_)
+{
+  if(n_ >= ARM_SWI_HLE_CALLS)
+    return 0;
+
+  if(swi_)
+    *swi_ = g_SWI_HLE_CALLS[n_].swi;
+  if(hits_)
+    *hits_ = g_SWI_HLE_CALLS[n_].hits;
+
+  return 1;
+}
+
+static void decode_swi_hle(const uint32_t op_)
+{
+  uint32_t       i;
+  uint32_t       swi;
+  arm_swi_hle_t *call;
+  arm_swi_mem_t  mem[ARM_SWI_HLE_MEM_SLOTS];
+
+  swi  = (op_ & 0x000FFFFF);
+  call = g_SWI_HLE_INDEX[ARM_SWI_HLE_INDEX(swi)];
+  if((call != NULL) && (call->swi == swi))
+    {
+      arm_prof_hle(swi);
+      call->hits++;
+      memset(mem,0,sizeof(mem));
+      call->mem(mem);
+      for(i = 0; i < ARM_SWI_HLE_MEM_SLOTS; i++)
+        opera_madam_sync_range(mem[i].addr,mem[i].len);
+      call->func();
+      opera_madam_dram_dirty(mem[0].addr,mem[0].len);
+      if(call->invalidate != NULL)
+        call->invalidate();
+      else
+        opera_arm_decode_cache_invalidate(mem[0].addr,mem[0].len);
+      return;
+    }
+
+  decode_swi_lle();
+}
+
+static void decode_swi(const uint32_t op_)
+{
+  CYCLES -= (SCYCLE + NCYCLE);  // +2S+1N
+  arm_prof_swi(op_);
+
+  if(g_SWI_HLE)
+  {
+    decode_swi_hle(op_);
+    return;
+  }
+
+  decode_swi_lle();
+}
+
+
+static uint32_t carry_out = 0;
+
+static
+INLINE
+void
+ARM_SET_C(const uint32_t x_)
+{
+  CPU.CPSR = ((CPU.CPSR & 0xdfffffff) | ((x_ & 1) << 29));
+}
+
+static
+INLINE
+void
+ARM_SET_Z(const uint32_t x_)
+{
+  CPU.CPSR = ((CPU.CPSR & 0xbfffffff) | (x_ == 0 ? 0x40000000 : 0));
+}
+
+static
+INLINE
+void
+ARM_SET_N(const uint32_t x_)
+{
+  CPU.CPSR = ((CPU.CPSR & 0x7fffffff) | (x_ & 0x80000000));
+}
+
+static
+INLINE
+uint32_t
+ARM_GET_C(void)
+{
+  return ((CPU.CPSR >> 29) & 1);
+}
+
+static
+INLINE
+void
+ARM_SET_ZN(const uint32_t val_)
+{
+  if(val_)
+    CPU.CPSR = ((CPU.CPSR & 0x3fffffff) | (val_ & 0x80000000));
+  else
+    CPU.CPSR = ((CPU.CPSR & 0x3fffffff) | 0x40000000);
+}
+
+static
+INLINE
+void
+ARM_SET_CV(const uint32_t rd_,
+           const uint32_t op1_,
+           const uint32_t op2_)
+{
+  CPU.CPSR = ((CPU.CPSR & 0xcfffffff) |
+              ((((op1_ & op2_) | ((~rd_) & (op1_ | op2_))) & 0x80000000) >> 2) |
+              (((((op1_ & (op2_ & (~rd_))) | ((~op1_) & (~op2_) & rd_))) & 0x80000000) >> 3));
 }
 
 static
 INLINE
+void
+ARM_SET_CV_sub(uint32_t rd_,
+               uint32_t op1_,
+               uint32_t op2_)
+{
+  CPU.CPSR = ((CPU.CPSR & 0xcfffffff) |
+              ((((op1_ & (~op2_)) | ((~rd_) & (op1_ | (~op2_)))) & 0x80000000) >> 2) |
+              (((((op1_ & ((~op2_) & (~rd_))) | ((~op1_) & op2_ & rd_))) & 0x80000000) >> 3));
+}
+
+static
+FORCEINLINE
 int
 ARM_ALU_Exec(uint32_t  inst_,
              uint8_t   opc_,
@@ -1260,6 +1489,7 @@ ARM_ALU_Exec(uint32_t  inst_,
 }
 
 static
+FORCEINLINE
 uint32_t
 ARM_SHIFT_NSC(uint32_t value_,
               uint8_t  shift_,
@@ -1520,362 +1750,1074 @@ static const int is_logic[] =
     TRUE,TRUE,TRUE,TRUE
   };
 
-int32_t
-opera_arm_execute(void)
+static
+void
+arm_op_mul(const arm_op_t *op_)
 {
-  uint32_t op1;
-  uint32_t op2;
-  uint8_t shift;
-  uint8_t shtype;
-  uint32_t cmd;
-  uint32_t pc_tmp;
-  int isexeption;
+  uint32_t res;
 
-  isexeption = FALSE;
-  if((CPU.USER[15] == 0x94D60) &&
-     (CPU.USER[0] == 0x113000) &&
-     (CPU.USER[1] == 0x113000) &&
-     (CNBFIX == 0)             &&
-     (FIXMODE & FIX_BIT_TIMING_1))
+  res = ((calcbits(CPU.USER[op_->rs]) + 5) >> 1) - 1;
+  if(res > 16)
+    CYCLES -= 16;
+  else
+    CYCLES -= res;
+
+  if(op_->rd == op_->rm)
     {
-      CPU.USER[15] = 0x9E9CC;
-      CNBFIX = 1;
+      if(op_->cmd & (1 << 21))
+        {
+          CPU.USER[15] += 8;
+          res = CPU.USER[op_->rn];
+          CPU.USER[15] -= 8;
+        }
+      else
+        {
+          res = 0;
+        }
     }
-
-  cmd = mreadw(CPU.USER[15]);
-  CPU.USER[15] += 4;
-
-  CYCLES = -SCYCLE;
-  if((cmd == 0xE5101810) && (CPU.CPSR == 0x80000093))
-    isexeption = TRUE;
-
-  if(((cond_flags_cross[cmd >> 28] >> (CPU.CPSR >> 28)) & 1) &&
-     (isexeption == FALSE))
+  else
     {
-      switch((cmd >> 24) & 0xF)
+      res = CPU.USER[op_->rm] * CPU.USER[op_->rs];
+      if(op_->cmd & (1 << 21))
         {
-        case 0x0:               //Multiply
-          if((cmd & ARM_MUL_MASK) == ARM_MUL_SIGN)
-            {
-              uint32_t res = ((calcbits(CPU.USER[(cmd>>8)&0xf])+5)>>1)-1;
-              if(res > 16)
-                CYCLES -= 16;
-              else
-                CYCLES -= res;
-
-              if(((cmd >> 16) & 0xF) == (cmd & 0xF))
-                {
-                  if(cmd & (1 << 21))
-                    {
-                      CPU.USER[15] += 8;
-                      res=CPU.USER[(cmd >> 12) & 0xF];
-                      CPU.USER[15] -= 8;
-                    }
-                  else
-                    {
-                      res = 0;
-                    }
-                }
-              else
-                {
-                  if(cmd & (1 << 21))
-                    {
-                      res = CPU.USER[cmd & 0xF] * CPU.USER[(cmd >> 8) & 0xF];
-                      CPU.USER[15] += 8;
-                      res += CPU.USER[(cmd >> 12) & 0xF];
-                      CPU.USER[15] -= 8;
-                    }
-                  else
-                    {
-                      res = CPU.USER[cmd & 0xF] * CPU.USER[(cmd >> 8) & 0xF];
-                    }
-                }
-
-              if(cmd & (1 << 20))
-                ARM_SET_ZN(res);
-
-              CPU.USER[(cmd >> 16) & 0xF] = res;
-              break;
-            }
-        case 0x1:               //Single Data Swap
-          if((cmd & ARM_SDS_MASK) == ARM_SDS_SIGN)
-            {
-              ARM_SWAP(cmd);
-              //if(MAS_Access_Exept)
-              CYCLES -= (2 * NCYCLE + ICYCLE);
-              break;
-            }
-        case 0x2:               //ALU
-        case 0x3:
-          {
-            if((cmd & 0x2000090) != 0x90)
-              {
-                /* SHIFT */
-                pc_tmp = CPU.USER[15];
-                CPU.USER[15] += 4;
-                if(cmd & (1 << 25))
-                  {
-                    op2 = cmd & 0xFF;
-                    if(((cmd >> 7) & 0x1E))
-                      {
-                        op2 = ROTR(op2,((cmd >> 7) & 0x1E));
-                        //if((cmd&(1<<20))) SETC(((cmd&0xff)>>(((cmd>>7)&0x1e)-1))&1);
-                      }
-                    op1 = CPU.USER[(cmd >> 16) & 0xF];
-                  }
-                else
-                  {
-                    shtype = ((cmd >> 5) & 0x3);
-                    if(cmd & (1 << 4))
-                      {
-                        shift = ((cmd >> 8) & 0xF);
-                        shift = (CPU.USER[shift] & 0xFF);
-                        CPU.USER[15] += 4;
-                        op2 = CPU.USER[cmd & 0xF];
-                        op1 = CPU.USER[(cmd >> 16) & 0xF];
-                        CYCLES -= ICYCLE;
-                      }
-                    else
-                      {
-                        shift = ((cmd >> 7) & 0x1F);
-
-                        if(!shift)
-                          {
-                            if(shtype)
-                              {
-                                if(shtype == 3)
-                                  shtype++;
-                                else
-                                  shift=32;
-                              }
-                          }
-
-                        op2 = CPU.USER[cmd & 0xF];
-                        op1 = CPU.USER[(cmd >> 16) & 0xF];
-                      }
-
-                    //if((cmd&(1<<20)) && is_logic[((cmd>>21)&0xf)] ) op2=ARM_SHIFT_SC(op2, shift, shtype);
-                    //else
-                    op2 = ARM_SHIFT_NSC(op2,shift,shtype);
-                  }
-
-                CPU.USER[15] = pc_tmp;
-
-                if((cmd & (1 << 20)) && is_logic[((cmd >> 21) & 0xF)])
-                  ARM_SET_C(carry_out);
-
-                if(ARM_ALU_Exec(cmd,((cmd >> 20) & 0x1F),op1,op2,&CPU.USER[(cmd >> 12) & 0xF]))
-                  break;
-
-                if(((cmd >> 12) & 0xF) == 0xF) //destination = pc, take care of cpsr
-                  {
-                    if(cmd & (1 << 20))
-                      arm_cpsr_set(CPU.SPSR[arm_mode_table[MODE]]);
-
-                    CYCLES -= (ICYCLE + NCYCLE);
-                  }
-                break;
-              }
-          }
-        case 0x6:               //Undefined
-        case 0x7:
-        Undefine:
-          if((cmd & ARM_UND_MASK) == ARM_UND_SIGN)
-            {
-              CPU.SPSR[arm_mode_table[0x1b]] = CPU.CPSR;
-              SETI(1);
-              SETM(0x1b);
-              CPU.USER[14] = CPU.USER[15];
-              CPU.USER[15] = 0x00000004;
-              CYCLES -= (SCYCLE + NCYCLE); // +2S+1N
-              break;
-            }
-        case 0x4:               //Single Data Transfer
-        case 0x5:
-          if((cmd & 0x2000090) != 0x2000090)
-            {
-              uint32_t base;
-              uint32_t tbas;
-              uint32_t oper2;
-              uint32_t val;
-              uint32_t rora;
-
-              pc_tmp = CPU.USER[15];
-              CPU.USER[15] += 4;
-              if(cmd & (1 << 25))
-                {
-                  shtype = ((cmd >> 5) & 0x3);
-                  if(cmd & (1 << 4))
-                    {
-                      shift = ((cmd >> 8) & 0xF);
-                      shift = (CPU.USER[shift] & 0xFF);
-                      CPU.USER[15] += 4;
-                    }
-                  else
-                    {
-                      shift = ((cmd >> 7) & 0x1F);
-                      if(!shift)
-                        {
-                          if(shtype)
-                            {
-                              if(shtype == 3)
-                                shtype++;
-                              else
-                                shift = 32;
-                            }
-                        }
-                    }
+          CPU.USER[15] += 8;
+          res += CPU.USER[op_->rn];
+          CPU.USER[15] -= 8;
+        }
+    }
 
-                  oper2 = ARM_SHIFT_NSC(CPU.USER[cmd & 0xF],shift,shtype);
-                }
-              else
-                {
-                  oper2 = (cmd & 0x0FFF);
-                }
+  if(op_->cmd & (1 << 20))
+    ARM_SET_ZN(res);
 
-              tbas = base = CPU.USER[((cmd >> 16) & 0xF)];
+  CPU.USER[op_->rd] = res;
+}
 
-              if(!(cmd & (1 << 23)))
-                oper2 = (0 - oper2);
+static
+void
+arm_op_swap(const arm_op_t *op_)
+{
+  ARM_SWAP(op_->cmd);
+  CYCLES -= (2 * NCYCLE + ICYCLE);
+}
 
-              if(cmd & (1 << 24))
-                tbas = base = (base + oper2);
-              else
-                base = (base + oper2);
+/*
+  The data processing bodies take the opcode and shift type as
+  arguments. The generic handlers pass the decoded fields while the
+  specialized ones below pass constants, letting the compiler drop the
+  opcode and shift type switches.
+*/
+static
+FORCEINLINE
+void
+arm_op_alu_exec(const arm_op_t *op_,
+                const uint8_t   opc_,
+                const uint32_t  op1_,
+                const uint32_t  op2_)
+{
+  if((opc_ & 1) && is_logic[opc_ >> 1])
+    ARM_SET_C(carry_out);
 
-              if(cmd & (1 << 20)) //load
-                {
-                  if(cmd & (1 << 22)) //bytes
-                    {
-                      val = mreadb(tbas);
-                    }
-                  else //words/halfwords
-                    {
-                      uint32_t rora;
+  if(ARM_ALU_Exec(op_->cmd,opc_,op1_,op2_,&CPU.USER[op_->rd]))
+    return;
 
-                      rora = tbas & 3;
-                      val = mreadw(tbas);
+  if(op_->rd == 0xF) //destination = pc, take care of cpsr
+    {
+      if(opc_ & 1)
+        arm_cpsr_set(CPU.SPSR[arm_mode_table[MODE]]);
 
-                      if(rora)
-                        val = ROTR(val,rora*8);
-                    }
+      CYCLES -= (ICYCLE + NCYCLE);
+    }
+}
 
-                  if(((cmd >> 12) & 0xF) == 0xF)
-                    CYCLES -= (SCYCLE + NCYCLE);   // +1S+1N ifR15 load
+static
+FORCEINLINE
+void
+arm_op_alu_imm_exec(const arm_op_t *op_,
+                    const uint8_t   opc_)
+{
+  uint32_t op1;
 
-                  CYCLES -= (NCYCLE + ICYCLE);  // +1N+1I
-                  CPU.USER[15] = pc_tmp;
+  CPU.USER[15] += 4;
+  op1 = CPU.USER[op_->rn];
+  CPU.USER[15] -= 4;
 
-                  if((cmd & (1 << 21)) || (!(cmd & (1 << 24))))
-                    CPU.USER[(cmd >> 16) & 0xF] = base;
+  arm_op_alu_exec(op_,opc_,op1,op_->imm);
+}
 
-                  if((cmd & (1 << 21)) && !(cmd & (1 << 24)))
-                    loadusr((cmd >> 12) & 0xF,val);
-                  else
-                    CPU.USER[(cmd >> 12) & 0xF] = val;
-                }
-              else // store
-                {
-                  if((cmd & (1 << 21)) && !(cmd & (1 << 24)))
-                    val = readusr((cmd >> 12) & 0xF);
-                  else
-                    val = CPU.USER[(cmd >> 12) & 0xF];
+static
+FORCEINLINE
+void
+arm_op_alu_reg_imm_exec(const arm_op_t *op_,
+                        const uint8_t   opc_,
+                        const uint8_t   shtype_)
+{
+  uint32_t op1;
+  uint32_t op2;
 
-                  CPU.USER[15] = pc_tmp;
-                  CYCLES -= (-SCYCLE + 2 * NCYCLE);  // 2N
+  CPU.USER[15] += 4;
+  op2 = CPU.USER[op_->rm];
+  op1 = CPU.USER[op_->rn];
+  CPU.USER[15] -= 4;
 
-                  if(cmd & (1 << 22)) //bytes/words
-                    mwriteb(tbas,val);
-                  else //words/halfwords
-                    mwritew(tbas,val);
+  op2 = ARM_SHIFT_NSC(op2,op_->shift,shtype_);
 
-                  if((cmd & (1 << 21)) || !(cmd & (1 << 24)))
-                    CPU.USER[(cmd >> 16) & 0xF] = base;
-                }
+  arm_op_alu_exec(op_,opc_,op1,op2);
+}
 
-              //if(MAS_Access_Exept)
-              break;
-            }
-          else
-            {
-              goto Undefine;
-            }
+static
+FORCEINLINE
+void
+arm_op_alu_reg_reg_exec(const arm_op_t *op_,
+                        const uint8_t   opc_,
+                        const uint8_t   shtype_)
+{
+  uint32_t op1;
+  uint32_t op2;
+  uint8_t  shift;
 
-        case 0x8:               //Block Data Transfer
-        case 0x9:
-          bdt_core(cmd);
-          /*if(MAS_Access_Exept)
-            {
-            //sprintf(str,"*PC: 0x%8.8X DataAbort!!!\n",CPU.USER[15]);
-            //CDebug::DPrint(str);
-            //!!Exeption!!
-
-            CPU.SPSR[arm_mode_table[0x17]]=CPU.CPSR;
-            SETI(1);
-            SETM(0x17);
-            CPU.USER[14] = (CPU.USER[15] + 4);
-            CPU.USER[15] = 0x00000010;
-            CYCLES-=SCYCLE+NCYCLE;
-            MAS_Access_Exept=FALSE;
-            break;
-            } */
-          break;
-
-        case 0xa:               //BRANCH
-        case 0xb:
-          if(cmd & (1 << 24))
-            CPU.USER[14] = CPU.USER[15];
-          CPU.USER[15] += ((((cmd & 0x00FFFFFF) | ((cmd & 0x00800000) ? 0xFF000000 : 0)) << 2) + 4);
-
-          CYCLES -= (SCYCLE + NCYCLE); //2S+1N
-          break;
-
-        case 0xf:               //SWI
-          decode_swi(cmd);
-          break;
-
-        default:                //coprocessor
-          CPU.SPSR[arm_mode_table[0x1b]] = CPU.CPSR;
-          SETI(1);
-          SETM(0x1b);
-          CPU.USER[14] = CPU.USER[15];
-          CPU.USER[15] = 0x00000004;
-          CYCLES -= (SCYCLE + NCYCLE);
-          break;
-        }
-    }
+  CPU.USER[15] += 4;
+  shift = (CPU.USER[op_->rs] & 0xFF);
+  CPU.USER[15] += 4;
+  op2 = CPU.USER[op_->rm];
+  op1 = CPU.USER[op_->rn];
+  CPU.USER[15] -= 8;
+  CYCLES -= ICYCLE;
 
-  if(!ISF && opera_clio_fiq_needed()/*CPU.nFIQ*/)
-    {
-      //Set_madam_FSM(FSM_SUSPENDED);
-      CPU.nFIQ = FALSE;
-      CPU.SPSR[arm_mode_table[0x11]] = CPU.CPSR;
-      SETF(1);
-      SETI(1);
-      SETM(0x11);
-      CPU.USER[14] = (CPU.USER[15] + 4);
-      CPU.USER[15] = 0x0000001C;
-    }
+  op2 = ARM_SHIFT_NSC(op2,shift,shtype_);
 
-  return -CYCLES;
+  arm_op_alu_exec(op_,opc_,op1,op2);
 }
 
+static
 void
-opera_mem_write8(uint32_t addr_,
-                 uint8_t  val_)
+arm_op_alu_imm(const arm_op_t *op_)
 {
-  CPU.ram[addr_] = val_;
-  if(!HIRESMODE || (addr_ < 0x200000))
-    return;
-  CPU.ram[addr_ + 1*1024*1024] = val_;
-  CPU.ram[addr_ + 2*1024*1024] = val_;
-  CPU.ram[addr_ + 3*1024*1024] = val_;
+  arm_op_alu_imm_exec(op_,op_->opc);
 }
 
+static
 void
-opera_mem_write16(uint32_t addr_,
-                  uint16_t val_)
+arm_op_alu_reg_imm(const arm_op_t *op_)
 {
+  arm_op_alu_reg_imm_exec(op_,op_->opc,op_->shtype);
+}
+
+static
+void
+arm_op_alu_reg_reg(const arm_op_t *op_)
+{
+  arm_op_alu_reg_reg_exec(op_,op_->opc,op_->shtype);
+}
+
+/*
+  Operand forms of the data processing handlers. The shifted register
+  forms follow the decoded shift type, 0-3 and 4 for RRX.
+*/
+enum
+  {
+    ARM_ALU_IMM,
+    ARM_ALU_LSL,
+    ARM_ALU_LSR,
+    ARM_ALU_ASR,
+    ARM_ALU_ROR,
+    ARM_ALU_RRX,
+    ARM_ALU_LSL_REG,
+    ARM_ALU_LSR_REG,
+    ARM_ALU_ASR_REG,
+    ARM_ALU_ROR_REG,
+    ARM_ALU_FORMS,
+    ARM_ALU_NONE = ARM_ALU_FORMS
+  };
+
+/* opcode and S bit pairs, MRS and MSR (16, 18, 20, 22) stay generic */
+#define ARM_ALU_OPCODES(X)                                              \
+  X(0)  X(1)  X(2)  X(3)  X(4)  X(5)  X(6)  X(7)                        \
+  X(8)  X(9)  X(10) X(11) X(12) X(13) X(14) X(15)                       \
+  X(17) X(19) X(21) X(23)                                               \
+  X(24) X(25) X(26) X(27) X(28) X(29) X(30) X(31)
+
+#define ARM_ALU_HANDLER_IMM(OPC)                                        \
+  static void arm_op_alu_imm_##OPC(const arm_op_t *op_)                 \
+  { arm_op_alu_imm_exec(op_,OPC); }
+
+#define ARM_ALU_HANDLER_REG_IMM(OPC,NAME,SHTYPE)                        \
+  static void arm_op_alu_##NAME##_##OPC(const arm_op_t *op_)            \
+  { arm_op_alu_reg_imm_exec(op_,OPC,SHTYPE); }
+
+#define ARM_ALU_HANDLER_REG_REG(OPC,NAME,SHTYPE)                        \
+  static void arm_op_alu_##NAME##_reg_##OPC(const arm_op_t *op_)        \
+  { arm_op_alu_reg_reg_exec(op_,OPC,SHTYPE); }
+
+#define ARM_ALU_HANDLERS(OPC)                                           \
+  ARM_ALU_HANDLER_IMM(OPC)                                              \
+  ARM_ALU_HANDLER_REG_IMM(OPC,lsl,0)                                    \
+  ARM_ALU_HANDLER_REG_IMM(OPC,lsr,1)                                    \
+  ARM_ALU_HANDLER_REG_IMM(OPC,asr,2)                                    \
+  ARM_ALU_HANDLER_REG_IMM(OPC,ror,3)                                    \
+  ARM_ALU_HANDLER_REG_IMM(OPC,rrx,4)                                    \
+  ARM_ALU_HANDLER_REG_REG(OPC,lsl,0)                                    \
+  ARM_ALU_HANDLER_REG_REG(OPC,lsr,1)                                    \
+  ARM_ALU_HANDLER_REG_REG(OPC,asr,2)                                    \
+  ARM_ALU_HANDLER_REG_REG(OPC,ror,3)
+
+ARM_ALU_OPCODES(ARM_ALU_HANDLERS)
+
+static arm_op_handler_t g_ALU_HANDLERS[ARM_ALU_FORMS][32];
+
+static
+void
+arm_alu_handlers_init(void)
+{
+  int i;
+
+  for(i = 0; i < 32; i++)
+    {
+      g_ALU_HANDLERS[ARM_ALU_IMM][i]     = arm_op_alu_imm;
+      g_ALU_HANDLERS[ARM_ALU_LSL][i]     = arm_op_alu_reg_imm;
+      g_ALU_HANDLERS[ARM_ALU_LSR][i]     = arm_op_alu_reg_imm;
+      g_ALU_HANDLERS[ARM_ALU_ASR][i]     = arm_op_alu_reg_imm;
+      g_ALU_HANDLERS[ARM_ALU_ROR][i]     = arm_op_alu_reg_imm;
+      g_ALU_HANDLERS[ARM_ALU_RRX][i]     = arm_op_alu_reg_imm;
+      g_ALU_HANDLERS[ARM_ALU_LSL_REG][i] = arm_op_alu_reg_reg;
+      g_ALU_HANDLERS[ARM_ALU_LSR_REG][i] = arm_op_alu_reg_reg;
+      g_ALU_HANDLERS[ARM_ALU_ASR_REG][i] = arm_op_alu_reg_reg;
+      g_ALU_HANDLERS[ARM_ALU_ROR_REG][i] = arm_op_alu_reg_reg;
+    }
+
+#define ARM_ALU_HANDLERS_SET(OPC)                                       \
+  g_ALU_HANDLERS[ARM_ALU_IMM][OPC]     = arm_op_alu_imm_##OPC;          \
+  g_ALU_HANDLERS[ARM_ALU_LSL][OPC]     = arm_op_alu_lsl_##OPC;          \
+  g_ALU_HANDLERS[ARM_ALU_LSR][OPC]     = arm_op_alu_lsr_##OPC;          \
+  g_ALU_HANDLERS[ARM_ALU_ASR][OPC]     = arm_op_alu_asr_##OPC;          \
+  g_ALU_HANDLERS[ARM_ALU_ROR][OPC]     = arm_op_alu_ror_##OPC;          \
+  g_ALU_HANDLERS[ARM_ALU_RRX][OPC]     = arm_op_alu_rrx_##OPC;          \
+  g_ALU_HANDLERS[ARM_ALU_LSL_REG][OPC] = arm_op_alu_lsl_reg_##OPC;      \
+  g_ALU_HANDLERS[ARM_ALU_LSR_REG][OPC] = arm_op_alu_lsr_reg_##OPC;      \
+  g_ALU_HANDLERS[ARM_ALU_ASR_REG][OPC] = arm_op_alu_asr_reg_##OPC;      \
+  g_ALU_HANDLERS[ARM_ALU_ROR_REG][OPC] = arm_op_alu_ror_reg_##OPC;
+
+  ARM_ALU_OPCODES(ARM_ALU_HANDLERS_SET)
+
+#undef ARM_ALU_HANDLERS_SET
+}
+
+static
+INLINE
+void
+arm_op_sdt_exec(const arm_op_t *op_,
+                const uint32_t  oper2_)
+{
+  uint32_t cmd;
+  uint32_t base;
+  uint32_t tbas;
+  uint32_t val;
+  uint32_t pc_tmp;
+
+  cmd = op_->cmd;
+
+  /* R15 reads as the instruction address + 8 */
+  pc_tmp = CPU.USER[15];
+  CPU.USER[15] += 4;
+
+  tbas = base = CPU.USER[op_->rn];
+
+  if(cmd & (1 << 24))
+    tbas = base = (base + oper2_);
+  else
+    base = (base + oper2_);
+
+  if(cmd & (1 << 20)) //load
+    {
+      if(cmd & (1 << 22)) //bytes
+        {
+          val = mreadb(tbas);
+        }
+      else //words/halfwords
+        {
+          uint32_t rora;
+
+          rora = tbas & 3;
+          val = mreadw(tbas);
+
+          if(rora)
+            val = ROTR(val,rora*8);
+        }
+
+      if(op_->rd == 0xF)
+        CYCLES -= (SCYCLE + NCYCLE);   // +1S+1N ifR15 load
+
+      CYCLES -= (NCYCLE + ICYCLE);  // +1N+1I
+      CPU.USER[15] = pc_tmp;
+
+      if((cmd & (1 << 21)) || (!(cmd & (1 << 24))))
+        CPU.USER[op_->rn] = base;
+
+      if((cmd & (1 << 21)) && !(cmd & (1 << 24)))
+        loadusr(op_->rd,val);
+      else
+        CPU.USER[op_->rd] = val;
+    }
+  else // store
+    {
+      if((cmd & (1 << 21)) && !(cmd & (1 << 24)))
+        val = readusr(op_->rd);
+      else
+        val = CPU.USER[op_->rd];
+
+      CPU.USER[15] = pc_tmp;
+      CYCLES -= (-SCYCLE + 2 * NCYCLE);  // 2N
+
+      if(cmd & (1 << 22)) //bytes/words
+        mwriteb(tbas,val);
+      else //words/halfwords
+        mwritew(tbas,val);
+
+      if((cmd & (1 << 21)) || !(cmd & (1 << 24)))
+        CPU.USER[op_->rn] = base;
+    }
+}
+
+static
+void
+arm_op_sdt_imm(const arm_op_t *op_)
+{
+  arm_op_sdt_exec(op_,op_->imm);
+}
+
+static
+void
+arm_op_sdt_reg(const arm_op_t *op_)
+{
+  uint32_t oper2;
+
+  CPU.USER[15] += 4;
+  oper2 = ARM_SHIFT_NSC(CPU.USER[op_->rm],op_->shift,op_->shtype);
+  CPU.USER[15] -= 4;
+
+  if(!(op_->cmd & (1 << 23)))
+    oper2 = (0 - oper2);
+
+  arm_op_sdt_exec(op_,oper2);
+}
+
+static
+void
+arm_op_bdt(const arm_op_t *op_)
+{
+  bdt_core(op_->cmd);
+}
+
+static
+void
+arm_op_branch(const arm_op_t *op_)
+{
+  if(op_->cmd & (1 << 24))
+    CPU.USER[14] = CPU.USER[15];
+  CPU.USER[15] += op_->imm;
+
+  CYCLES -= (SCYCLE + NCYCLE); //2S+1N
+}
+
+static
+void
+arm_op_swi(const arm_op_t *op_)
+{
+  g_IDLE.dirty = TRUE;
+  decode_swi(op_->cmd);
+}
+
+/* undefined instructions and coprocessor operations */
+static
+void
+arm_op_undefined(const arm_op_t *op_)
+{
+  CPU.SPSR[arm_mode_table[0x1b]] = CPU.CPSR;
+  SETI(1);
+  SETM(0x1b);
+  CPU.USER[14] = CPU.USER[15];
+  CPU.USER[15] = 0x00000004;
+  CYCLES -= (SCYCLE + NCYCLE); // +2S+1N
+}
+
+/*
+  Decode table
+
+  Bits 27:20 and 7:4 of an instruction select its handler: the class,
+  the data processing opcode, S bit and operand form, and the multiply
+  and swap signatures. arm_op_decode() extracts the fields handlers
+  read and settles the two cases the index can't see, RRX (ROR #0)
+  and swaps with bits 11:8 set which execute as transfers.
+*/
+
+#define ARM_DECODE_INDEX(cmd_) ((((cmd_) >> 16) & 0xFF0) | (((cmd_) >> 4) & 0xF))
+
+static arm_op_handler_t g_ARM_DECODE[4096];
+
+/* operand form of a data processing instruction or ARM_ALU_NONE */
+static
+int
+arm_op_alu_form(const uint32_t cmd_)
+{
+  switch((cmd_ >> 25) & 0x7)
+    {
+    case 0x0:
+      /* multiplies, swaps and the transfers sharing their pattern */
+      if((cmd_ & 0x90) == 0x90)
+        return ARM_ALU_NONE;
+      if(cmd_ & (1 << 4))
+        return (ARM_ALU_LSL_REG + ((cmd_ >> 5) & 0x3));
+      return (ARM_ALU_LSL + ((cmd_ >> 5) & 0x3));
+    case 0x1:
+      return ARM_ALU_IMM;
+    }
+
+  return ARM_ALU_NONE;
+}
+
+static
+arm_op_handler_t
+arm_op_decode_handler(const uint32_t cmd_)
+{
+  int form;
+
+  form = arm_op_alu_form(cmd_);
+  if(form != ARM_ALU_NONE)
+    return g_ALU_HANDLERS[form][(cmd_ >> 20) & 0x1F];
+
+  switch((cmd_ >> 25) & 0x7)
+    {
+    case 0x0:
+      if((cmd_ & ARM_MUL_MASK) == ARM_MUL_SIGN)
+        return arm_op_mul;
+      if((cmd_ & ARM_SDS_MASK) == ARM_SDS_SIGN)
+        return arm_op_swap;
+      /* not a valid ARM60 encoding, executes as a transfer */
+      return arm_op_sdt_imm;
+    case 0x2:
+      return arm_op_sdt_imm;
+    case 0x3:
+      if(cmd_ & (1 << 4))
+        return arm_op_undefined;
+      return arm_op_sdt_reg;
+    case 0x4:
+      return arm_op_bdt;
+    case 0x5:
+      return arm_op_branch;
+    case 0x7:
+      if(cmd_ & (1 << 24))
+        return arm_op_swi;
+      break;
+    }
+
+  return arm_op_undefined;
+}
+
+static
+void
+arm_decode_table_init(void)
+{
+  uint32_t i;
+
+  arm_alu_handlers_init();
+
+  for(i = 0; i < 4096; i++)
+    g_ARM_DECODE[i] = arm_op_decode_handler(((i & 0xFF0) << 16) |
+                                            ((i & 0x00F) <<  4));
+}
+
+static
+void
+arm_op_decode_alu(arm_op_t       *op_,
+                  const uint32_t  cmd_)
+{
+  op_->opc = ((cmd_ >> 20) & 0x1F);
+
+  if(cmd_ & (1 << 25))
+    {
+      op_->imm = ROTR(cmd_ & 0xFF,((cmd_ >> 7) & 0x1E));
+      return;
+    }
+
+  op_->shtype = ((cmd_ >> 5) & 0x3);
+  if(cmd_ & (1 << 4))
+    return;
+
+  op_->shift = ((cmd_ >> 7) & 0x1F);
+  if(!op_->shift && op_->shtype)
+    {
+      if(op_->shtype == 3)
+        {
+          op_->shtype++;
+          op_->handler = g_ALU_HANDLERS[ARM_ALU_RRX][op_->opc];
+        }
+      else
+        {
+          op_->shift = 32;
+        }
+    }
+}
+
+static
+void
+arm_op_decode_sdt(arm_op_t       *op_,
+                  const uint32_t  cmd_)
+{
+  if(cmd_ & (1 << 25))
+    {
+      /* register offsets with bit 4 set decode as undefined */
+      op_->shtype = ((cmd_ >> 5) & 0x3);
+      op_->shift  = ((cmd_ >> 7) & 0x1F);
+      if(!op_->shift && op_->shtype)
+        {
+          if(op_->shtype == 3)
+            op_->shtype++;
+          else
+            op_->shift = 32;
+        }
+
+      return;
+    }
+
+  op_->imm = (cmd_ & 0x0FFF);
+  if(!(cmd_ & (1 << 23)))
+    op_->imm = (0 - op_->imm);
+}
+
+static
+void
+arm_op_decode(arm_op_t       *op_,
+              const uint32_t  cmd_)
+{
+  op_->cmd = cmd_;
+  op_->rd  = ((cmd_ >> 12) & 0xF);
+  op_->rn  = ((cmd_ >> 16) & 0xF);
+  op_->rs  = ((cmd_ >>  8) & 0xF);
+  op_->rm  = ((cmd_ >>  0) & 0xF);
+
+  op_->handler = g_ARM_DECODE[ARM_DECODE_INDEX(cmd_)];
+
+  switch((cmd_ >> 25) & 0x7)
+    {
+    case 0x0:
+      if((cmd_ & ARM_MUL_MASK) == ARM_MUL_SIGN)
+        {
+          op_->rd = ((cmd_ >> 16) & 0xF);
+          op_->rn = ((cmd_ >> 12) & 0xF);
+        }
+      else if((cmd_ & 0x90) != 0x90)
+        {
+          arm_op_decode_alu(op_,cmd_);
+        }
+      else if((cmd_ & ARM_SDS_MASK) != ARM_SDS_SIGN)
+        {
+          /* not a valid ARM60 encoding, executes as a transfer */
+          op_->handler = arm_op_sdt_imm;
+          arm_op_decode_sdt(op_,cmd_);
+        }
+      break;
+    case 0x1:
+      arm_op_decode_alu(op_,cmd_);
+      break;
+    case 0x2:
+      arm_op_decode_sdt(op_,cmd_);
+      break;
+    case 0x3:
+      if(!(cmd_ & (1 << 4)))
+        arm_op_decode_sdt(op_,cmd_);
+      break;
+    case 0x5:
+      op_->imm = ((((cmd_ & 0x00FFFFFF) | ((cmd_ & 0x00800000) ? 0xFF000000 : 0)) << 2) + 4);
+      break;
+    }
+}
+
+static
+arm_op_t*
+arm_op_page_alloc(arm_op_t **page_)
+{
+  *page_ = calloc(ARM_OP_PAGE_OPS,sizeof(arm_op_t));
+
+  if((page_ >= &g_OPS_DRAM[0]) && (page_ < &g_OPS_DRAM[ARM_OP_DRAM_PAGES]))
+    arm_bus_dram_code_page((page_ - &g_OPS_DRAM[0]) << ARM_OP_PAGE_SHIFT);
+
+  return *page_;
+}
+
+#if defined(HAVE_DYNAREC) && defined(__x86_64__)
+#include "opera_arm_dynarec_x64.ic"
+#else
+#include "opera_arm_dynarec_none.ic"
+#endif
+
+static
+void
+arm_op_pages_free(arm_op_t **pages_,
+                  const int  count_)
+{
+  int i;
+
+  for(i = 0; i < count_; i++)
+    {
+      free(pages_[i]);
+      pages_[i] = NULL;
+    }
+}
+
+static
+void
+arm_op_pages_flush(arm_op_t **pages_,
+                   const int  count_)
+{
+  int i;
+  int j;
+
+  for(i = 0; i < count_; i++)
+    {
+      if(pages_[i] == NULL)
+        continue;
+
+      for(j = 0; j < ARM_OP_PAGE_OPS; j++)
+        pages_[i][j].handler = NULL;
+    }
+}
+
+static
+void
+arm_decode_cache_flush(void)
+{
+  arm_op_pages_flush(g_OPS_DRAM,ARM_OP_DRAM_PAGES);
+  arm_op_pages_flush(g_OPS_ROM1,ARM_OP_ROM_PAGES);
+  arm_op_pages_flush(g_OPS_ROM2,ARM_OP_ROM_PAGES);
+  arm_dynarec_flush();
+}
+
+static
+void
+arm_decode_cache_free(void)
+{
+  arm_dynarec_free();
+  arm_op_pages_free(g_OPS_DRAM,ARM_OP_DRAM_PAGES);
+  arm_op_pages_free(g_OPS_ROM1,ARM_OP_ROM_PAGES);
+  arm_op_pages_free(g_OPS_ROM2,ARM_OP_ROM_PAGES);
+}
+
+static
+INLINE
+void
+arm_decode_cache_invalidate_word(const uint32_t addr_)
+{
+  arm_op_t *page;
+
+  if(addr_ >= RAM_SIZE)
+    return;
+
+  page = g_OPS_DRAM[addr_ >> ARM_OP_PAGE_SHIFT];
+  if(page == NULL)
+    return;
+
+  page[(addr_ >> 2) & (ARM_OP_PAGE_OPS - 1)].handler = NULL;
+  arm_dynarec_invalidate_word(page,addr_);
+}
+
+void
+opera_arm_decode_cache_invalidate(const uint32_t addr_,
+                                  const uint32_t len_)
+{
+  uint32_t i;
+  uint32_t end;
+  arm_op_t *page;
+
+  if(addr_ >= RAM_SIZE)
+    return;
+
+  end = (((len_ > (RAM_SIZE - addr_)) ? RAM_SIZE : (addr_ + len_)) + 3) & ~3;
+  for(i = (addr_ & ~3); i < end; i += 4)
+    {
+      page = g_OPS_DRAM[i >> ARM_OP_PAGE_SHIFT];
+      if(page == NULL)
+        {
+          i |= ((1 << ARM_OP_PAGE_SHIFT) - 4);
+          continue;
+        }
+
+      page[(i >> 2) & (ARM_OP_PAGE_OPS - 1)].handler = NULL;
+      arm_dynarec_invalidate_word(page,i);
+    }
+}
+
+static
+INLINE
+const arm_op_t*
+arm_op_fetch(const uint32_t pc_)
+{
+  arm_op_t  *op;
+  arm_op_t **pages;
+  uint32_t   offset;
+
+  if(pc_ < RAM_SIZE)
+    {
+      pages  = g_OPS_DRAM;
+      offset = pc_;
+    }
+  else if(!((pc_ ^ 0x03000000) & ~0xFFFFF) ||
+          !((pc_ ^ 0x06000000) & ~0xFFFFF))
+    {
+      pages  = g_OPS_ROM;
+      offset = (pc_ & 0xFFFFF);
+    }
+  else
+    {
+      /* fetches from I/O space keep their side effects */
+      arm_op_decode(&g_OP_UNCACHED,mreadw(pc_));
+      return &g_OP_UNCACHED;
+    }
+
+  op = pages[offset >> ARM_OP_PAGE_SHIFT];
+  if((op == NULL) &&
+     (arm_op_page_alloc(&pages[offset >> ARM_OP_PAGE_SHIFT]) == NULL))
+    {
+      arm_op_decode(&g_OP_UNCACHED,mreadw(pc_));
+      return &g_OP_UNCACHED;
+    }
+
+  op = &pages[offset >> ARM_OP_PAGE_SHIFT][(offset >> 2) & (ARM_OP_PAGE_OPS - 1)];
+  if(op->handler == NULL)
+    arm_op_decode(op,mreadw(pc_));
+
+  return op;
+}
+
+static
+INLINE
+int32_t
+arm_execute(void)
+{
+  const arm_op_t *op;
+
+  if((CPU.USER[15] == 0x94D60) &&
+     (CPU.USER[0] == 0x113000) &&
+     (CPU.USER[1] == 0x113000) &&
+     (CNBFIX == 0)             &&
+     (FIXMODE & FIX_BIT_TIMING_1))
+    {
+      CPU.USER[15] = 0x9E9CC;
+      CNBFIX = 1;
+      g_IDLE.dirty = TRUE;
+    }
+
+  op = arm_op_fetch(CPU.USER[15]);
+  CPU.USER[15] += 4;
+
+  CYCLES = -SCYCLE;
+  if(((cond_flags_cross[op->cmd >> 28] >> (CPU.CPSR >> 28)) & 1) &&
+     !((op->cmd == 0xE5101810) && (CPU.CPSR == 0x80000093)))
+    op->handler(op);
+
+  if(!ISF && opera_clio_fiq_needed()/*CPU.nFIQ*/)
+    {
+      //Set_madam_FSM(FSM_SUSPENDED);
+      CPU.nFIQ = FALSE;
+      CPU.SPSR[arm_mode_table[0x11]] = CPU.CPSR;
+      SETF(1);
+      SETI(1);
+      SETM(0x11);
+      CPU.USER[14] = (CPU.USER[15] + 4);
+      CPU.USER[15] = 0x0000001C;
+    }
+
+  return -CYCLES;
+}
+
+int32_t
+opera_arm_execute(void)
+{
+  return arm_execute();
+}
+
+/* in the FIQ handler or entering it after the next instruction */
+int
+opera_arm_fiq_busy(void)
+{
+  return ((MODE == 0x11) || (!ISF && opera_clio_fiq_needed()));
+}
+
+static
+void
+arm_idle_reset(void)
+{
+  g_IDLE.state = ARM_IDLE_SEARCH;
+  g_IDLE.dirty = TRUE;
+  g_IDLE.hits  = 0;
+  g_IDLE.ahead = 0;
+}
+
+static
+void
+arm_idle_backoff(void)
+{
+  g_IDLE.state = ARM_IDLE_SEARCH;
+  g_IDLE.hits  = -ARM_IDLE_BACKOFF;
+}
+
+/* the CPU is at the head, snapshot it and record an iteration */
+static
+void
+arm_idle_record(void)
+{
+  g_IDLE.state     = ARM_IDLE_RECORD;
+  g_IDLE.dirty     = FALSE;
+  g_IDLE.io        = FALSE;
+  g_IDLE.pos       = 0;
+  g_IDLE.sum[0]    = 0;
+  g_IDLE.carry_out = carry_out;
+  g_IDLE.regs      = CPU;
+}
+
+/* a short backward branch to head_ was taken */
+static
+void
+arm_idle_branch(const uint32_t head_)
+{
+  if(!g_IDLE_SKIP)
+    return;
+
+  if(head_ != g_IDLE.head)
+    {
+      g_IDLE.head = head_;
+      g_IDLE.hits = 0;
+      return;
+    }
+
+  if(++g_IDLE.hits < ARM_IDLE_HITS)
+    return;
+
+  g_IDLE.fails = 0;
+  arm_idle_record();
+}
+
+/* account for one instruction stepped while recording or locked */
+static
+void
+arm_idle_step(const int32_t cycles_)
+{
+  g_IDLE.pos++;
+  if(g_IDLE.state == ARM_IDLE_RECORD)
+    g_IDLE.sum[g_IDLE.pos] = (g_IDLE.sum[g_IDLE.pos - 1] + cycles_);
+
+  if(CPU.USER[15] != g_IDLE.head)
+    {
+      if(g_IDLE.pos >= ARM_IDLE_MAX_OPS)
+        arm_idle_backoff();
+      return;
+    }
+
+  if(g_IDLE.state == ARM_IDLE_LOCKED)
+    {
+      if(!g_IDLE.dirty && (g_IDLE.pos == g_IDLE.ops))
+        {
+          g_IDLE.pos = 0;
+          return;
+        }
+
+      /* something changed since the lock, verify the loop again */
+      g_IDLE.fails = 0;
+      arm_idle_record();
+      return;
+    }
+
+  if(!g_IDLE.dirty &&
+     (g_IDLE.carry_out == carry_out) &&
+     !memcmp(&g_IDLE.regs,&CPU,sizeof(arm_core_t)))
+    {
+      g_IDLE.state  = ARM_IDLE_LOCKED;
+      g_IDLE.ops    = g_IDLE.pos;
+      g_IDLE.period = g_IDLE.sum[g_IDLE.pos];
+      g_IDLE.pos    = 0;
+      g_IDLE.locks++;
+      return;
+    }
+
+  if(++g_IDLE.fails >= ARM_IDLE_RETRIES)
+    arm_idle_backoff();
+  else
+    arm_idle_record();
+}
+
+/* execute the instructions opera_arm_idle_skip() only replayed */
+static
+void
+arm_idle_sync(void)
+{
+  while(g_IDLE.ahead)
+    {
+      g_IDLE.ahead--;
+      arm_idle_step(arm_execute());
+    }
+}
+
+/*
+  Replay a locked idle loop for the whole instructions that fit before
+  limit_, the point where the caller has a clock event to deliver.
+  Returns the cycles they would have used or 0 without doing anything
+  if the CPU isn't idle or not one fits.
+*/
+int32_t
+opera_arm_idle_skip(const int32_t limit_)
+{
+  uint32_t pos;
+  uint32_t op;
+  int32_t  start;
+  int32_t  target;
+  int32_t  iters;
+  int32_t  used;
+
+  if((g_IDLE.state != ARM_IDLE_LOCKED) || g_IDLE.dirty || (limit_ <= 0))
+    return 0;
+
+  pos = (g_IDLE.pos + g_IDLE.ahead);
+  if(pos >= g_IDLE.ops)
+    pos -= g_IDLE.ops;
+
+  /* the run ends on the last instruction boundary before the limit */
+  start  = g_IDLE.sum[pos];
+  target = (start + limit_);
+  iters  = (target / g_IDLE.period);
+  target = (target - (iters * g_IDLE.period));
+  for(op = 0; g_IDLE.sum[op] < target; op++)
+    ;
+  if(op == 0)
+    {
+      iters--;
+      op = g_IDLE.ops;
+    }
+  op--;
+
+  used = ((iters * g_IDLE.period) + g_IDLE.sum[op] - start);
+  if(used <= 0)
+    return 0;
+
+  g_IDLE.ahead = ((op >= g_IDLE.pos) ?
+                  (op - g_IDLE.pos) :
+                  (op + g_IDLE.ops - g_IDLE.pos));
+  g_IDLE.skipped += used;
+  arm_prof_idle(g_IDLE.head,used);
+
+  return used;
+}
+
+/* something outside the CPU may have changed memory */
+void
+opera_arm_idle_break(void)
+{
+  g_IDLE.dirty = TRUE;
+}
+
+/*
+  A clock event fired. Events update device registers and may raise
+  an FIQ but only write memory through opera_mem_write*() so a loop
+  polling memory alone is still locked if no FIQ is pending.
+*/
+void
+opera_arm_idle_event(void)
+{
+  if(g_IDLE.io || opera_clio_fiq_needed())
+    g_IDLE.dirty = TRUE;
+}
+
+void
+opera_arm_idle_set(const int enable_)
+{
+  g_IDLE_SKIP = !!enable_;
+  arm_idle_reset();
+}
+
+int
+opera_arm_idle_get(void)
+{
+  return g_IDLE_SKIP;
+}
+
+void
+opera_arm_idle_stats(uint64_t *locks_,
+                     uint64_t *skipped_)
+{
+  if(locks_)
+    *locks_ = g_IDLE.locks;
+  if(skipped_)
+    *skipped_ = g_IDLE.skipped;
+}
+
+/*
+  Run until at least budget_ cycles have been used or until a write
+  started the cel engine. Returns the cycles used, which may exceed
+  the budget by the length of the last instruction exactly as single
+  stepping would.
+*/
+int32_t
+opera_arm_run(const int32_t budget_)
+{
+  int      dynarec;
+  int32_t  cycles;
+  int32_t  step;
+  uint32_t pc;
+
+  g_RUN_BREAK = FALSE;
+
+  arm_idle_sync();
+
+  dynarec = opera_arm_dynarec_get();
+  cycles  = 0;
+  do
+    {
+      pc = CPU.USER[15];
+      if(g_IDLE.state != ARM_IDLE_SEARCH)
+        {
+          step = arm_execute();
+          arm_idle_step(step);
+        }
+      else
+        {
+          if(dynarec)
+            step = opera_arm_dynarec_execute(budget_ - cycles);
+          else
+            step = arm_execute();
+
+          if((CPU.USER[15] <= pc) && ((pc - CPU.USER[15]) < ARM_IDLE_SPAN))
+            arm_idle_branch(CPU.USER[15]);
+        }
+
+      arm_prof_step(pc,step);
+
+      cycles += step;
+    } while((cycles < budget_) && !g_RUN_BREAK);
+
+  return cycles;
+}
+
+void
+opera_mem_write8(uint32_t addr_,
+                 uint8_t  val_)
+{
+  g_IDLE.dirty = TRUE;
+  arm_decode_cache_invalidate_word(addr_);
+  arm_bus_watch_write(addr_);
+
+  CPU.ram[addr_] = val_;
+  if(!HIRESMODE || (addr_ < 0x200000))
+    return;
+  CPU.ram[addr_ + 1*1024*1024] = val_;
+  CPU.ram[addr_ + 2*1024*1024] = val_;
+  CPU.ram[addr_ + 3*1024*1024] = val_;
+}
+
+void
+opera_mem_write16(uint32_t addr_,
+                  uint16_t val_)
+{
+  g_IDLE.dirty = TRUE;
+  arm_decode_cache_invalidate_word(addr_);
+  arm_bus_watch_write(addr_);
+
   *((uint16_t*)&CPU.ram[addr_]) = val_;
   if(!HIRESMODE || (addr_ < 0x200000))
     return;
@@ -1888,6 +2830,10 @@ void
 opera_mem_write32(uint32_t addr_,
                   uint32_t val_)
 {
+  g_IDLE.dirty = TRUE;
+  arm_decode_cache_invalidate_word(addr_);
+  arm_bus_watch_write(addr_);
+
   *((uint32_t*)&CPU.ram[addr_]) = val_;
   if(!HIRESMODE || (addr_ < 0x200000))
     return;
@@ -1914,151 +2860,495 @@ opera_mem_read8(uint32_t addr_)
   return CPU.ram[addr_];
 }
 
-static void mwritew(uint32_t addr_, uint32_t val_)
+/*
+  Bus page table
+
+  Every 64KB page of the ARM address space either maps straight onto
+  host memory (DRAM and the selected ROM bank) or names the handler
+  for the device behind it. Reads of a mapped page are a lookup and a
+  load. Writes only take the direct path for DRAM pages without
+  predecoded code, and never for VRAM since it is mirrored in hires
+  mode.
+*/
+
+static
+uint32_t
+bus_unmapped_read32(const uint32_t addr_)
 {
-   uint32_t index;
+  (void)addr_;
 
-   addr_ &= ~3;
+  /* MAS_Access_Exept = TRUE; */
 
-   if(addr_ < 0x00300000)
-   {
-      opera_mem_write32(addr_,val_);
-      return;
-   }
+  return 0xBADACCE5;
+}
 
-   index = (addr_ ^ 0x03300000);
-   if(!(index & ~0x7FF))
-   {
-      opera_madam_poke(index,val_);
-      return;
-   }
+static
+void
+bus_unmapped_write32(const uint32_t addr_,
+                     const uint32_t val_)
+{
+  (void)addr_;
+  (void)val_;
+}
 
-   index = (addr_ ^ 0x03400000);
-   if(!(index & ~0xFFFF))
-   {
-      if(opera_clio_poke(index,val_))
-         CPU.USER[15] += 4;  /* ??? */
-      return;
-   }
+static
+uint32_t
+bus_unmapped_read8(const uint32_t addr_)
+{
+  (void)addr_;
 
-   index = (addr_ ^ 0x03200000);
-   if(!(index & ~0xFFFFF))
-   {
-      opera_sport_write_access(index,val_);
-      return;
-   }
+  /* MAS_Access_Exept = TRUE; */
 
-   index = (addr_ ^ 0x03100000);
-   if(!(index & ~0xFFFFF))
-   {
-      if(index & 0x80000)
-         opera_diag_port_send(val_);
-      else if(index & 0x40000)
-         CPU.nvram[(index >> 2) & 0x7FFF] = (uint8_t)val_;
-   }
+  return 0xBADACCE5;
+}
+
+static
+void
+bus_unmapped_write8(const uint32_t addr_,
+                    const uint8_t  val_)
+{
+  (void)addr_;
+  (void)val_;
 }
 
+/*
+  DRAM only traps here for VRAM writes, pages holding predecoded code,
+  pages fenced while an async cel list is drawn and pages holding
+  cached cel data.
+*/
 static
 uint32_t
-mreadw(uint32_t addr_)
+bus_dram_read32(const uint32_t addr_)
 {
-  int32_t index;
+  opera_madam_sync_range(addr_,4);
+  return opera_mem_read32(addr_);
+}
 
-  addr_ &= ~3;
+static
+void
+bus_dram_write32(const uint32_t addr_,
+                 const uint32_t val_)
+{
+  opera_madam_sync_range(addr_,4);
+  opera_mem_write32(addr_,val_);
+}
+
+static
+uint32_t
+bus_dram_read8(const uint32_t addr_)
+{
+  opera_madam_sync_range(addr_,1);
+  return opera_mem_read8(addr_ ^ 3);
+}
+
+static
+void
+bus_dram_write8(const uint32_t addr_,
+                const uint8_t  val_)
+{
+  opera_madam_sync_range(addr_,1);
+  opera_mem_write8(addr_ ^ 3,val_);
+}
+
+static
+uint32_t
+bus_rom_read32(const uint32_t addr_)
+{
+  return *(uint32_t*)&CPU.rom[addr_ & 0xFFFFF];
+}
+
+static
+uint32_t
+bus_rom_read8(const uint32_t addr_)
+{
+  return CPU.rom[(addr_ & 0xFFFFF) ^ 3];
+}
 
-  if(addr_ < 0x00300000)
-    return opera_mem_read32(addr_);
+static
+uint32_t
+bus_madam_read32(const uint32_t addr_)
+{
+  uint32_t index;
 
-  index = (addr_ ^ 0x03300000);
-  if(!(index & ~0xFFFFF))
-    return opera_madam_peek(index);
+  /* reading the fifos pops them */
+  index = (addr_ & 0xFFFFF);
+  if((index >= 0x400) && (index <= 0x53F))
+    g_IDLE.dirty = TRUE;
 
-  index = (addr_ ^ 0x03400000);
-  if(!(index & ~0xFFFFF))
-    return opera_clio_peek(index);
+  return opera_madam_peek(index);
+}
 
-  index = (addr_ ^ 0x03200000);
-  if(!(index & ~0xFFFFF))
-    {
-      if(!(index & ~0x1FFF))
-        return (opera_sport_set_source(index),0);
-      return 0xBADACCE5;
-    }
+static
+void
+bus_madam_write32(const uint32_t addr_,
+                  const uint32_t val_)
+{
+  uint32_t index;
+
+  index = (addr_ & 0xFFFFF);
+  if(index & ~0x7FF)
+    return;
+
+  opera_madam_poke(index,val_);
+  if(opera_madam_fsm_get() == FSM_INPROCESS)
+    g_RUN_BREAK = TRUE;
+}
 
-  /* Standard ROM */
-  index = (addr_ ^ 0x03000000);
-  if(!(index & ~0xFFFFF))
-    return *(uint32_t*)&CPU.rom[index];
+static
+uint32_t
+bus_clio_read32(const uint32_t addr_)
+{
+  uint32_t index;
+
+  /* xbus, DSP and semaphore reads have side effects or change alone */
+  index = (addr_ & 0xFFFFF);
+  if(index >= 0x500)
+    g_IDLE.dirty = TRUE;
+
+  return opera_clio_peek(index);
+}
+
+static
+void
+bus_clio_write32(const uint32_t addr_,
+                 const uint32_t val_)
+{
+  uint32_t index;
+
+  index = (addr_ & 0xFFFFF);
+  if(index & ~0xFFFF)
+    return;
+
+  if(opera_clio_poke(index,val_))
+    CPU.USER[15] += 4;  /* ??? */
+}
+
+static
+uint32_t
+bus_sport_read32(const uint32_t addr_)
+{
+  uint32_t index;
+
+  index = (addr_ & 0xFFFFF);
+  if(index & ~0x1FFF)
+    return 0xBADACCE5;
+
+  g_IDLE.dirty = TRUE;
+  opera_sport_set_source(index);
+
+  return 0;
+}
+
+static
+void
+bus_sport_write32(const uint32_t addr_,
+                  const uint32_t val_)
+{
+  opera_sport_write_access(addr_ & 0xFFFFF,val_);
+}
 
-  /* ANVIL ROM */
-  index = (addr_ ^ 0x06000000);
-  if(!(index & ~0xFFFFF))
-    return *(uint32_t*)&CPU.rom[index];
+static
+uint32_t
+bus_nvram_read32(const uint32_t addr_)
+{
+  uint32_t index;
 
-  index = (addr_ ^ 0x03100000);
-  if(!(index & ~0xFFFFF))
+  index = (addr_ & 0xFFFFF);
+  if(index & 0x80000)
+    {
+      g_IDLE.dirty = TRUE;
+      return opera_diag_port_get();
+    }
+  else if(index & 0x40000)
     {
-      if(index & 0x80000)
-        return opera_diag_port_get();
-      else if(index & 0x40000)
-        return CPU.nvram[(index >> 2) & 0x7FFF];
+      return CPU.nvram[(index >> 2) & 0x7FFF];
     }
 
-  /* MAS_Access_Exept = TRUE; */
+  return 0xBADACCE5;
+}
+
+static
+void
+bus_nvram_write32(const uint32_t addr_,
+                  const uint32_t val_)
+{
+  uint32_t index;
+
+  index = (addr_ & 0xFFFFF);
+  if(index & 0x80000)
+    opera_diag_port_send(val_);
+  else if(index & 0x40000)
+    CPU.nvram[(index >> 2) & 0x7FFF] = (uint8_t)val_;
+}
+
+static
+uint32_t
+bus_nvram_read8(const uint32_t addr_)
+{
+  uint32_t index;
+
+  index = ((addr_ & 0xFFFFF) ^ 3);
+  if(index & 0x40000)
+    return CPU.nvram[(index >> 2) & 0x7FFF];
 
   return 0xBADACCE5;
 }
 
-static void mwriteb(uint32_t addr_, uint8_t  val_)
+static
+void
+bus_nvram_write8(const uint32_t addr_,
+                 const uint8_t  val_)
 {
-  int32_t index;
+  uint32_t index;
+
+  index = ((addr_ & 0xFFFFF) ^ 3);
+  if(index & 0x40000)
+    CPU.nvram[(index >> 2) & 0x7FFF] = val_;
+}
 
-  if(addr_ < 0x00300000)
+static const arm_bus_io_t g_BUS_HANDLERS[ARM_BUS_IO_COUNT] =
   {
-    opera_mem_write8(addr_ ^ 3,val_);
+    /* ARM_BUS_IO_UNMAPPED */
+    {bus_unmapped_read32,bus_unmapped_write32,bus_unmapped_read8,bus_unmapped_write8},
+    /* ARM_BUS_IO_DRAM */
+    {bus_dram_read32,bus_dram_write32,bus_dram_read8,bus_dram_write8},
+    /* ARM_BUS_IO_ROM */
+    {bus_rom_read32,bus_unmapped_write32,bus_rom_read8,bus_unmapped_write8},
+    /* ARM_BUS_IO_MADAM */
+    {bus_madam_read32,bus_madam_write32,bus_unmapped_read8,bus_unmapped_write8},
+    /* ARM_BUS_IO_CLIO */
+    {bus_clio_read32,bus_clio_write32,bus_unmapped_read8,bus_unmapped_write8},
+    /* ARM_BUS_IO_SPORT */
+    {bus_sport_read32,bus_sport_write32,bus_unmapped_read8,bus_unmapped_write8},
+    /* ARM_BUS_IO_NVRAM */
+    {bus_nvram_read32,bus_nvram_write32,bus_nvram_read8,bus_nvram_write8}
+  };
+
+static
+void
+arm_bus_map(const uint32_t addr_,
+            const uint32_t size_,
+            const uint8_t  io_,
+            uint8_t       *rd_,
+            uint8_t       *wr_)
+{
+  uint32_t i;
+  uint32_t page;
+
+  for(i = 0; i < size_; i += ARM_BUS_PAGE_SIZE)
+    {
+      page = ((addr_ + i) >> ARM_BUS_PAGE_SHIFT);
+      g_BUS_IO[page] = io_;
+      g_BUS_RD[page] = ((rd_ != NULL) ? (rd_ + i) : NULL);
+      g_BUS_WR[page] = ((wr_ != NULL) ? (wr_ + i) : NULL);
+    }
+}
+
+/* predecoded code lives in this DRAM page, writes must invalidate it */
+static
+void
+arm_bus_dram_code_page(const uint32_t addr_)
+{
+  if(addr_ < RAM_SIZE)
+    g_BUS_WR[addr_ >> ARM_BUS_PAGE_SHIFT] = NULL;
+}
+
+static
+void
+arm_bus_dram_build(void)
+{
+  uint32_t i;
+
+  arm_bus_map(0x00000000,RAM_SIZE - VRAM_SIZE,ARM_BUS_IO_DRAM,CPU.ram,CPU.ram);
+  arm_bus_map(RAM_SIZE - VRAM_SIZE,VRAM_SIZE,ARM_BUS_IO_DRAM,CPU.ram + RAM_SIZE - VRAM_SIZE,NULL);
+
+  for(i = 0; i < ARM_OP_DRAM_PAGES; i++)
+    if(g_OPS_DRAM[i] != NULL)
+      arm_bus_dram_code_page(i << ARM_OP_PAGE_SHIFT);
+
+  for(i = 0; i < (RAM_SIZE >> ARM_BUS_PAGE_SHIFT); i++)
+    if(g_BUS_WATCH & (1ULL << i))
+      g_BUS_WR[i] = NULL;
+}
+
+/*
+  The first store to a watched page marks it dirty for the cel cache
+  and unwatches it. The page is mapped for writes again unless
+  something else still needs them trapped.
+*/
+static
+void
+arm_bus_watch_write(const uint32_t addr_)
+{
+  uint32_t i;
+  uint32_t page;
+
+  page = (addr_ >> ARM_BUS_PAGE_SHIFT);
+  if((page >= (RAM_SIZE >> ARM_BUS_PAGE_SHIFT)) || !(g_BUS_WATCH & (1ULL << page)))
     return;
-  }
 
-  index = (addr_ ^ 0x03100003);
-  if(!(index & ~0xFFFFF))
-  {
-     if((index & 0x40000) == 0x40000)
-     {
-        CPU.nvram[(index >> 2) & 0x7FFF] = val_;
-        return;
-     }
-  }
+  g_BUS_WATCH &= ~(1ULL << page);
+  opera_madam_dram_dirty(page << ARM_BUS_PAGE_SHIFT,ARM_BUS_PAGE_SIZE);
+
+  if(((page << ARM_BUS_PAGE_SHIFT) >= (RAM_SIZE - VRAM_SIZE)) ||
+     (g_BUS_FENCE & (1ULL << page)))
+    return;
+
+  for(i = 0; i < (ARM_BUS_PAGE_SIZE >> ARM_OP_PAGE_SHIFT); i++)
+    if(g_OPS_DRAM[(page << (ARM_BUS_PAGE_SHIFT - ARM_OP_PAGE_SHIFT)) + i] != NULL)
+      return;
+
+  g_BUS_WR[page] = &CPU.ram[page << ARM_BUS_PAGE_SHIFT];
+}
+
+static
+void
+arm_bus_build(void)
+{
+  /* this drops any fence */
+  opera_madam_sync();
+
+  memset(g_BUS_IO,ARM_BUS_IO_UNMAPPED,sizeof(g_BUS_IO));
+  memset(g_BUS_RD,0,sizeof(g_BUS_RD));
+  memset(g_BUS_WR,0,sizeof(g_BUS_WR));
+
+  if(CPU.ram == NULL)
+    return;
+
+  arm_bus_dram_build();
+  arm_bus_map(0x03000000,ROM1_SIZE,ARM_BUS_IO_ROM,CPU.rom,NULL);
+  arm_bus_map(0x03100000,0x00100000,ARM_BUS_IO_NVRAM,NULL,NULL);
+  arm_bus_map(0x03200000,0x00100000,ARM_BUS_IO_SPORT,NULL,NULL);
+  arm_bus_map(0x03300000,0x00100000,ARM_BUS_IO_MADAM,NULL,NULL);
+  arm_bus_map(0x03400000,0x00100000,ARM_BUS_IO_CLIO,NULL,NULL);
+  arm_bus_map(0x06000000,ROM1_SIZE,ARM_BUS_IO_ROM,CPU.rom,NULL);
+}
+
+/*
+  Send the CPU's accesses to DRAM pages overlapping the range through
+  the handlers, writes only unless reads_ is set.
+*/
+void
+opera_arm_bus_fence(const uint32_t addr_,
+                    const uint32_t len_,
+                    const int      reads_)
+{
+  uint32_t page;
+  uint32_t last;
+
+  if((len_ == 0) || (addr_ >= RAM_SIZE))
+    return;
+
+  last = (((len_ > (RAM_SIZE - addr_)) ? RAM_SIZE : (addr_ + len_)) - 1);
+  for(page = (addr_ >> ARM_BUS_PAGE_SHIFT); page <= (last >> ARM_BUS_PAGE_SHIFT); page++)
+    {
+      g_BUS_FENCE   |= (1ULL << page);
+      g_BUS_WR[page] = NULL;
+      if(reads_)
+        g_BUS_RD[page] = NULL;
+    }
+}
+
+void
+opera_arm_bus_unfence(void)
+{
+  g_BUS_FENCE = 0;
+  if(CPU.ram != NULL)
+    arm_bus_dram_build();
+}
+
+/*
+  Send the CPU's stores to DRAM pages overlapping the range through
+  the handlers until the first one, which is reported to the cel
+  cache with opera_madam_dram_dirty().
+*/
+void
+opera_arm_bus_watch(const uint32_t addr_,
+                    const uint32_t len_)
+{
+  uint32_t page;
+  uint32_t last;
+
+  if((len_ == 0) || (addr_ >= RAM_SIZE))
+    return;
+
+  last = (((len_ > (RAM_SIZE - addr_)) ? RAM_SIZE : (addr_ + len_)) - 1);
+  for(page = (addr_ >> ARM_BUS_PAGE_SHIFT); page <= (last >> ARM_BUS_PAGE_SHIFT); page++)
+    {
+      g_BUS_WATCH   |= (1ULL << page);
+      g_BUS_WR[page] = NULL;
+    }
+}
+
+static
+void
+mwritew(uint32_t addr_,
+        uint32_t val_)
+{
+  uint8_t *page;
+
+  addr_ &= ~3;
+  g_IDLE.dirty = TRUE;
+
+  page = g_BUS_WR[addr_ >> ARM_BUS_PAGE_SHIFT];
+  if(page != NULL)
+    {
+      *(uint32_t*)&page[addr_ & ARM_BUS_PAGE_MASK] = val_;
+      return;
+    }
+
+  g_BUS_HANDLERS[g_BUS_IO[addr_ >> ARM_BUS_PAGE_SHIFT]].write32(addr_,val_);
 }
 
 static
 uint32_t
-mreadb(uint32_t addr_)
+mreadw(uint32_t addr_)
 {
-  int32_t index;
+  const uint8_t *page;
+
+  addr_ &= ~3;
+
+  page = g_BUS_RD[addr_ >> ARM_BUS_PAGE_SHIFT];
+  if(page != NULL)
+    return *(const uint32_t*)&page[addr_ & ARM_BUS_PAGE_MASK];
 
-  if(addr_ < 0x00300000)
-    return opera_mem_read8(addr_ ^ 3);
+  g_IDLE.io = TRUE;
 
-  /* Standard ROM */
-  index = (addr_ ^ 0x03000003);
-  if(!(index & ~0xFFFFF))
-    return CPU.rom[index];
+  return g_BUS_HANDLERS[g_BUS_IO[addr_ >> ARM_BUS_PAGE_SHIFT]].read32(addr_);
+}
+
+static
+void
+mwriteb(uint32_t addr_,
+        uint8_t  val_)
+{
+  uint8_t *page;
 
-  /* ANVIL ROM */
-  index = (addr_ ^ 0x06000003);
-  if(!(index & ~0xFFFFF))
-    return CPU.rom[index];
+  g_IDLE.dirty = TRUE;
 
-  index = (addr_ ^ 0x03100003);
-  if(!(index & ~0xFFFFF))
+  page = g_BUS_WR[addr_ >> ARM_BUS_PAGE_SHIFT];
+  if(page != NULL)
     {
-      if((index & 0x40000) == 0x40000)
-        return CPU.nvram[(index >> 2) & 0x7FFF];
+      page[(addr_ & ARM_BUS_PAGE_MASK) ^ 3] = val_;
+      return;
     }
 
-  /* MAS_Access_Exept = TRUE; */
+  g_BUS_HANDLERS[g_BUS_IO[addr_ >> ARM_BUS_PAGE_SHIFT]].write8(addr_,val_);
+}
 
-  return 0xBADACCE5;
+static
+uint32_t
+mreadb(uint32_t addr_)
+{
+  const uint8_t *page;
+
+  page = g_BUS_RD[addr_ >> ARM_BUS_PAGE_SHIFT];
+  if(page != NULL)
+    return page[(addr_ & ARM_BUS_PAGE_MASK) ^ 3];
+
+  g_IDLE.io = TRUE;
+
+  return g_BUS_HANDLERS[g_BUS_IO[addr_ >> ARM_BUS_PAGE_SHIFT]].read8(addr_);
 }
 
 static
@@ -38,6 +38,11 @@
 EXTERN_C_BEGIN
 
 int32_t  opera_arm_execute(void);
+int      opera_arm_fiq_busy(void);
+int32_t  opera_arm_run(const int32_t budget_);
+int32_t  opera_arm_idle_skip(const int32_t limit_);
+void     opera_arm_idle_break(void);
+void     opera_arm_idle_event(void);
 void     opera_arm_init(void);
 void     opera_arm_reset(void);
 void     opera_arm_destroy(void);
@@ -49,6 +54,11 @@ uint8_t  opera_mem_read8(uint32_t addr_);
 uint16_t opera_mem_read16(uint32_t addr_);
 uint32_t opera_mem_read32(uint32_t addr_);
 
+void     opera_arm_decode_cache_invalidate(const uint32_t addr_, const uint32_t len_);
+void     opera_arm_bus_fence(const uint32_t addr_, const uint32_t len_, const int reads_);
+void     opera_arm_bus_unfence(void);
+void     opera_arm_bus_watch(const uint32_t addr_, const uint32_t len_);
+
 void     opera_io_write(const uint32_t addr_, const uint32_t val_);
 uint32_t opera_io_read(const uint32_t addr_);
 
@@ -77,6 +87,19 @@ uint64_t opera_arm_vram_size(void);
 
 void     opera_arm_swi_hle_set(const int hle);
 int      opera_arm_swi_hle_get(void);
+int      opera_arm_swi_hle_stats(const uint32_t n_, uint32_t *swi_, uint64_t *hits_);
+
+int32_t  opera_arm_dynarec_execute(const int32_t budget_);
+void     opera_arm_dynarec_set(const int enable_);
+int      opera_arm_dynarec_get(void);
+
+void     opera_arm_idle_set(const int enable_);
+int      opera_arm_idle_get(void);
+void     opera_arm_idle_stats(uint64_t *locks_, uint64_t *skipped_);
+
+int      opera_arm_profile_enabled(void);
+int      opera_arm_profile_dump(const char *path_);
+void     opera_arm_profile_reset(void);
 
 EXTERN_C_END
 
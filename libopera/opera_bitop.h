@@ -27,24 +27,99 @@
 #include <stdint.h>
 
 #include "extern_c.h"
+#include "inline.h"
 
 EXTERN_C_BEGIN
 
+/*
+  MSB first reader over a big endian bit stream in DRAM. DRAM holds
+  the 3DO's big endian words as host words so a plain 32 bit load
+  gives the next 32 bits of the stream in order. The stream has to
+  start on a word boundary, which cel data always does.
+
+  window holds the unread bits left aligned and is refilled a word
+  at a time so a read is a shift in the common case.
+*/
 struct BitReaderBig
 {
-  uint32_t buf;
-  uint32_t point;
-  int32_t bitpoint;
-  int32_t bitset;
+  uint32_t        buf;
+  const uint32_t *word;
+  uint64_t        window;
+  uint32_t        bits;
+  uint32_t        bitpos;
 };
 
-uint32_t BitReaderBig_Read(struct BitReaderBig *bit, uint8_t bits);
-
 void BitReaderBig_AttachBuffer(struct BitReaderBig *bit, uint32_t buff);
 
-void BitReaderBig_SetBitRate(struct BitReaderBig *bit, uint8_t bits);
+static
+FORCEINLINE
+void
+BitReaderBig_Refill(struct BitReaderBig *bit_)
+{
+  bit_->window |= ((uint64_t)*bit_->word++ << (32 - bit_->bits));
+  bit_->bits   += 32;
+}
+
+/* bits_ is 1 to 32 */
+static
+FORCEINLINE
+uint32_t
+BitReaderBig_Read(struct BitReaderBig *bit_,
+                  const uint32_t       bits_)
+{
+  uint32_t rv;
+
+  if(!bit_->buf)
+    return 0;
+
+  if(bit_->bits < bits_)
+    BitReaderBig_Refill(bit_);
+
+  rv = (uint32_t)(bit_->window >> (64 - bits_));
+  bit_->window <<= bits_;
+  bit_->bits    -= bits_;
+  bit_->bitpos  += bits_;
 
-void BitReaderBig_Skip(struct BitReaderBig *bit, uint32_t bits);
+  return rv;
+}
+
+static
+FORCEINLINE
+void
+BitReaderBig_Skip(struct BitReaderBig *bit_,
+                  uint32_t             bits_)
+{
+  bit_->bitpos += bits_;
+
+  if(bits_ <= bit_->bits)
+    {
+      bit_->window <<= bits_;
+      bit_->bits    -= bits_;
+      return;
+    }
+
+  bits_       -= bit_->bits;
+  bit_->word  += (bits_ >> 5);
+  bit_->window = 0;
+  bit_->bits   = 0;
+
+  bits_ &= 31;
+  if(bits_)
+    {
+      BitReaderBig_Refill(bit_);
+      bit_->window <<= bits_;
+      bit_->bits    -= bits_;
+    }
+}
+
+/* byte offset of the next unread bit from the attached buffer */
+static
+FORCEINLINE
+uint32_t
+BitReaderBig_Point(const struct BitReaderBig *bit_)
+{
+  return (bit_->bitpos >> 3);
+}
 
 EXTERN_C_END
 
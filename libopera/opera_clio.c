@@ -168,6 +168,9 @@ clio_handle_dma(uint32_t val_)
       CLIO.regs[0x304] &= ~0x00100000;
       CLIO.regs[0x400] &= ~0x80;
 
+      if(len >= 0)
+        opera_madam_sync_range(trg,len + 4);
+
       if(CLIO.regs[0x404] & 0x200)
         {
           while(len >= 0)
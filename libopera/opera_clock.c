@@ -186,6 +186,35 @@ opera_clock_timer_queued(void)
   return 0;
 }
 
+static
+uint32_t
+cycles_until(const int32_t acc_,
+             const int32_t cycles_per_)
+{
+  if(acc_ >= cycles_per_)
+    return 0;
+
+  return (((uint32_t)(cycles_per_ - acc_) + 0xFFFF) >> 16);
+}
+
+/* fewest cycles which, pushed at once, queue any of the events */
+uint32_t
+opera_clock_cycles_until_event(void)
+{
+  uint32_t rv;
+  uint32_t tmp;
+
+  rv  = cycles_until(g_CLOCK.dsp_acc,g_CLOCK.cycles_per_snd);
+  tmp = cycles_until(g_CLOCK.vdl_acc,g_CLOCK.cycles_per_scanline);
+  if(tmp < rv)
+    rv = tmp;
+  tmp = cycles_until(g_CLOCK.timer_acc,g_CLOCK.cycles_per_timer);
+  if(tmp < rv)
+    rv = tmp;
+
+  return rv;
+}
+
 void
 opera_clock_push_cycles(const uint32_t clks_)
 {
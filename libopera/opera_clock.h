@@ -12,6 +12,7 @@ void     opera_clock_init(void);
 int      opera_clock_vdl_queued(void);
 int      opera_clock_dsp_queued(void);
 int      opera_clock_timer_queued(void);
+uint32_t opera_clock_cycles_until_event(void);
 
 void     opera_clock_push_cycles(const uint32_t clks);
 
@@ -1,3 +1,5 @@
+#include "inline.h"
+
 #include "opera_fixedpoint_math.h"
 
 static
@@ -106,11 +108,12 @@ MulMat33Mat33_F16(mat33f16 dest_,
 }
 
 /* swi 0x50002 */
+static
 void
-MulManyVec3Mat33_F16(vec3f16  *dest_,
-                     vec3f16  *src_,
-                     mat33f16  mat_,
-                     int32_t   count_)
+mul_many_vec3_mat33_f16_c(vec3f16  *dest_,
+                          vec3f16  *src_,
+                          mat33f16  mat_,
+                          int32_t   count_)
 {
   int32_t i;
   vec3f16 tmp;
@@ -133,12 +136,80 @@ MulManyVec3Mat33_F16(vec3f16  *dest_,
     }
 }
 
+/*
+  The object calls walk a list of objects in emulated memory. Entries
+  of objectlist_ and the array pointers inside each object are guest
+  addresses and so are resolved against ram_, the offsets locate
+  fields within an object.
+*/
+static
+INLINE
+uint8_t*
+object_get(uint8_t        *ram_,
+           const uint32_t  objectlist_,
+           const int32_t   i_)
+{
+  return &ram_[((uint32_t*)&ram_[objectlist_])[i_]];
+}
+
+static
+INLINE
+uint32_t
+object_field(const uint8_t *obj_,
+             const int32_t  offset_)
+{
+  return *(const uint32_t*)&obj_[offset_];
+}
+
+/* swi 0x50003 */
+void
+MulObjectVec3Mat33_F16(uint8_t          *ram_,
+                       uint32_t          objectlist_,
+                       const ObjOffset1 *offsetstruct_,
+                       int32_t           count_)
+{
+  int32_t  i;
+  uint8_t *obj;
+
+  for(i = 0; i < count_; i++)
+    {
+      obj = object_get(ram_,objectlist_,i);
+
+      MulManyVec3Mat33_F16((vec3f16*)&ram_[object_field(obj,offsetstruct_->oo1_DestArrayPtrOffset)],
+                           (vec3f16*)&ram_[object_field(obj,offsetstruct_->oo1_SrcArrayPtrOffset)],
+                           *(mat33f16*)&obj[offsetstruct_->oo1_MatOffset],
+                           (int32_t)object_field(obj,offsetstruct_->oo1_CountOffset));
+    }
+}
+
+/* swi 0x50004 */
+void
+MulObjectMat33_F16(uint8_t          *ram_,
+                   uint32_t          objectlist_,
+                   const ObjOffset2 *offsetstruct_,
+                   mat33f16          mat_,
+                   int32_t           count_)
+{
+  int32_t  i;
+  uint8_t *obj;
+
+  for(i = 0; i < count_; i++)
+    {
+      obj = object_get(ram_,objectlist_,i);
+
+      MulMat33Mat33_F16(*(mat33f16*)&obj[offsetstruct_->oo2_DestMatOffset],
+                        *(mat33f16*)&obj[offsetstruct_->oo2_SrcMatOffset],
+                        mat_);
+    }
+}
+
 /* swi 0x50005 */
+static
 void
-MulManyF16(frac16  *dest_,
-           frac16  *src1_,
-           frac16  *src2_,
-           int32_t  count_)
+mul_many_f16_c(frac16  *dest_,
+               frac16  *src1_,
+               frac16  *src2_,
+               int32_t  count_)
 {
   int32_t i;
   for(i = 0; i < count_; i++)
@@ -148,11 +219,12 @@ MulManyF16(frac16  *dest_,
 }
 
 /* swi 0x50006 */
+static
 void
-MulScalerF16(frac16  *dest_,
-             frac16  *src_,
-             frac16   scaler_,
-             int32_t  count_)
+mul_scaler_f16_c(frac16  *dest_,
+                 frac16  *src_,
+                 frac16   scaler_,
+                 int32_t  count_)
 {
   int32_t i;
   for(i = 0; i < count_; i++)
@@ -290,11 +362,12 @@ MulMat44Mat44_F16(mat44f16 dest_,
 }
 
 /* swi 0x50009 */
+static
 void
-MulManyVec4Mat44_F16(vec4f16  *dest_,
-                     vec4f16  *src_,
-                     mat44f16  mat_,
-                     int32_t   count_)
+mul_many_vec4_mat44_f16_c(vec4f16  *dest_,
+                          vec4f16  *src_,
+                          mat44f16  mat_,
+                          int32_t   count_)
 {
   int32_t i;
   vec4f16 tmp;
@@ -327,21 +400,44 @@ MulManyVec4Mat44_F16(vec4f16  *dest_,
 
 /* swi 0x5000A */
 void
-MulObjectVec4Mat44_F16(void       *objectlist[],
-                       ObjOffset1 *offsetstruct,
-                       int32_t     count)
+MulObjectVec4Mat44_F16(uint8_t          *ram_,
+                       uint32_t          objectlist_,
+                       const ObjOffset1 *offsetstruct_,
+                       int32_t           count_)
 {
+  int32_t  i;
+  uint8_t *obj;
+
+  for(i = 0; i < count_; i++)
+    {
+      obj = object_get(ram_,objectlist_,i);
 
+      MulManyVec4Mat44_F16((vec4f16*)&ram_[object_field(obj,offsetstruct_->oo1_DestArrayPtrOffset)],
+                           (vec4f16*)&ram_[object_field(obj,offsetstruct_->oo1_SrcArrayPtrOffset)],
+                           *(mat44f16*)&obj[offsetstruct_->oo1_MatOffset],
+                           (int32_t)object_field(obj,offsetstruct_->oo1_CountOffset));
+    }
 }
 
 /* swi 0x5000B */
 void
-MulObjectMat44_F16(void       *objectlist_[],
-                   ObjOffset2 *offsetstruct_,
-                   mat44f16    mat_,
-                   int32_t     count_)
+MulObjectMat44_F16(uint8_t          *ram_,
+                   uint32_t          objectlist_,
+                   const ObjOffset2 *offsetstruct_,
+                   mat44f16          mat_,
+                   int32_t           count_)
 {
+  int32_t  i;
+  uint8_t *obj;
+
+  for(i = 0; i < count_; i++)
+    {
+      obj = object_get(ram_,objectlist_,i);
 
+      MulMat44Mat44_F16(*(mat44f16*)&obj[offsetstruct_->oo2_DestMatOffset],
+                        *(mat44f16*)&obj[offsetstruct_->oo2_SrcMatOffset],
+                        mat_);
+    }
 }
 
 /* swi 0x5000C */
@@ -451,3 +547,94 @@ MulManyVec3Mat33DivZ_F16(vec3f16  *dest_,
   for(i = 0; i < count_; i++)
     MulVec3Mat33DivZ_F16(dest_[i],src_[i],*mat_,n_);
 }
+
+/*
+  SIMD dispatch
+
+  The batch calls run through the best kernels the host has, picked
+  once by opera_fixedpoint_math_init(). Every variant gives the same
+  results as the scalar code above.
+*/
+
+typedef void (*mul_many_vec3_mat33_f16_t)(vec3f16*,vec3f16*,mat33f16,int32_t);
+typedef void (*mul_many_vec4_mat44_f16_t)(vec4f16*,vec4f16*,mat44f16,int32_t);
+typedef void (*mul_many_f16_t)(frac16*,frac16*,frac16*,int32_t);
+typedef void (*mul_scaler_f16_t)(frac16*,frac16*,frac16,int32_t);
+
+static mul_many_vec3_mat33_f16_t g_MUL_MANY_VEC3_MAT33 = mul_many_vec3_mat33_f16_c;
+static mul_many_vec4_mat44_f16_t g_MUL_MANY_VEC4_MAT44 = mul_many_vec4_mat44_f16_c;
+static mul_many_f16_t            g_MUL_MANY            = mul_many_f16_c;
+static mul_scaler_f16_t          g_MUL_SCALER          = mul_scaler_f16_c;
+static const char               *g_SIMD_NAME           = "scalar";
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include "opera_fixedpoint_math_x86.ic"
+#elif defined(OPERA_NEON) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include "opera_fixedpoint_math_neon.ic"
+#else
+static
+void
+fixedpoint_math_simd_init(void)
+{
+
+}
+#endif
+
+void
+opera_fixedpoint_math_init(const int simd_)
+{
+  g_MUL_MANY_VEC3_MAT33 = mul_many_vec3_mat33_f16_c;
+  g_MUL_MANY_VEC4_MAT44 = mul_many_vec4_mat44_f16_c;
+  g_MUL_MANY            = mul_many_f16_c;
+  g_MUL_SCALER          = mul_scaler_f16_c;
+  g_SIMD_NAME           = "scalar";
+
+  if(simd_)
+    fixedpoint_math_simd_init();
+}
+
+const char*
+opera_fixedpoint_math_simd(void)
+{
+  return g_SIMD_NAME;
+}
+
+/* swi 0x50002 */
+void
+MulManyVec3Mat33_F16(vec3f16  *dest_,
+                     vec3f16  *src_,
+                     mat33f16  mat_,
+                     int32_t   count_)
+{
+  g_MUL_MANY_VEC3_MAT33(dest_,src_,mat_,count_);
+}
+
+/* swi 0x50005 */
+void
+MulManyF16(frac16  *dest_,
+           frac16  *src1_,
+           frac16  *src2_,
+           int32_t  count_)
+{
+  g_MUL_MANY(dest_,src1_,src2_,count_);
+}
+
+/* swi 0x50006 */
+void
+MulScalerF16(frac16  *dest_,
+             frac16  *src_,
+             frac16   scaler_,
+             int32_t  count_)
+{
+  g_MUL_SCALER(dest_,src_,scaler_,count_);
+}
+
+/* swi 0x50009 */
+void
+MulManyVec4Mat44_F16(vec4f16  *dest_,
+                     vec4f16  *src_,
+                     mat44f16  mat_,
+                     int32_t   count_)
+{
+  g_MUL_MANY_VEC4_MAT44(dest_,src_,mat_,count_);
+}
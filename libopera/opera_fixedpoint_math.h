@@ -36,12 +36,19 @@ struct ObjOffset2
   int32_t oo2_SrcMatOffset;
 };
 
+void        opera_fixedpoint_math_init(const int simd);
+const char* opera_fixedpoint_math_simd(void);
+
 /* swi 0x50000 */
 void MulVec3Mat33_F16(vec3f16  dest, vec3f16  vec, mat33f16 mat);
 /* swi 0x50001 */
 void MulMat33Mat33_F16(mat33f16 dest, mat33f16 src1, mat33f16 src2);
 /* swi 0x50002 */
 void MulManyVec3Mat33_F16(vec3f16 *dest, vec3f16 *src, mat33f16 mat, int32_t count);
+/* swi 0x50003 */
+void MulObjectVec3Mat33_F16(uint8_t *ram, uint32_t objectlist, const ObjOffset1 *offsetstruct, int32_t count);
+/* swi 0x50004 */
+void MulObjectMat33_F16(uint8_t *ram, uint32_t objectlist, const ObjOffset2 *offsetstruct, mat33f16 mat, int32_t count);
 /* swi 0x50005 */
 void MulManyF16(frac16 *dest, frac16 *src1, frac16 *src2, int32_t count);
 /* swi 0x50006 */
@@ -53,9 +60,9 @@ void MulMat44Mat44_F16(mat44f16 dest, mat44f16 src1, mat44f16 src2);
 /* swi 0x50009 */
 void MulManyVec4Mat44_F16(vec4f16 *dest, vec4f16 *src, mat44f16 mat, int32_t count);
 /* swi 0x5000A */
-void MulObjectVec4Mat44_F16(void *objectlist[], ObjOffset1 *offsetstruct, int32_t count);
+void MulObjectVec4Mat44_F16(uint8_t *ram, uint32_t objectlist, const ObjOffset1 *offsetstruct, int32_t count);
 /* swi 0x5000B */
-void MulObjectMat44_F16(void *objectlist[], ObjOffset2 *offsetstruct, mat44f16 mat, int32_t count);
+void MulObjectMat44_F16(uint8_t *ram, uint32_t objectlist, const ObjOffset2 *offsetstruct, mat44f16 mat, int32_t count);
 /* swi 0x5000C */
 frac16 Dot3_F16(vec3f16 v1, vec3f16 v2);
 /* swi 0x5000D */
@@ -40,13 +40,11 @@
 #include "opera_pbus.h"
 #include "opera_vdlp.h"
 
-#include <math.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-static struct BitReaderBig bitoper;
-
 /* === CCB control word flags === */
 #define CCB_SKIP        0x80000000
 #define CCB_LAST        0x40000000
@@ -372,6 +370,7 @@ typedef union PXC_u PXC_t;
 
 #define MADAM_REGISTER_COUNT   2048
 #define MADAM_PLUT_COUNT       32
+#define MADAM_CCB_MAX          (15 * 4)
 
 #pragma pack(pop)
 
@@ -395,6 +394,24 @@ typedef struct madam_s madam_t;
 #define MADAM_ID_GREEN_SOFTWARE 0x01020001
 
 static madam_t MADAM;
+
+/*
+  Where MADAM.PLUT was last loaded from and the DRAM generation at the
+  time, see LoadPLUT(). hash is the cel cache's key for the PLUT.
+*/
+struct madam_plut_s
+{
+  bool_t   valid;
+  bool_t   hashed;
+  uint32_t addr;
+  uint32_t len;
+  uint32_t epoch;
+  uint32_t gen;
+  uint64_t hash;
+};
+
+static struct madam_plut_s g_madam_plut;
+
 static int KPRINT  = 0;
 static int ME_MODE = ME_MODE_HARDWARE;
 
@@ -450,19 +467,25 @@ void
 opera_madam_state_load(const void *buf_)
 {
   memcpy(&MADAM,buf_,sizeof(madam_t));
+
+  g_madam_plut.valid  = FALSE;
+  g_madam_plut.hashed = FALSE;
 }
 
+typedef struct madam_ctx_s madam_ctx_t;
+
 static uint32_t mread32(uint32_t addr);
-static int32_t  TestInitVisual(int32_t packed);
-static int32_t  Init_Line_Map(void);
-static void     Init_Scale_Map(void);
-static void     Init_Arbitrary_Map(void);
-static void     TexelDraw_Line(uint16_t CURPIX, uint16_t LAMV, int32_t xcur, int32_t ycur, int32_t cnt);
-static int32_t  TexelDraw_Scale(uint16_t CURPIX, uint16_t LAMV, int32_t xcur, int32_t ycur, int32_t deltax, int32_t deltay);
-static int32_t  TexelDraw_Arbitrary(uint16_t CURPIX, uint16_t LAMV, int32_t xA, int32_t yA, int32_t xB, int32_t yB, int32_t xC, int32_t yC, int32_t xD, int32_t yD);
-static void     DrawPackedCel_New(void);
-static void     DrawLiteralCel_New(void);
-static void     DrawLRCel_New(void);
+static int32_t  TestInitVisual(madam_ctx_t *ctx_, int32_t packed);
+static int32_t  Init_Line_Map(madam_ctx_t *ctx_);
+static void     Init_Scale_Map(madam_ctx_t *ctx_);
+static void     Init_Arbitrary_Map(madam_ctx_t *ctx_);
+static void     TexelDraw_Line(madam_ctx_t *ctx_, uint16_t CURPIX, uint16_t LAMV, int32_t xcur, int32_t ycur, int32_t cnt);
+static int32_t  TexelDraw_Scale(madam_ctx_t *ctx_, uint16_t CURPIX, uint16_t LAMV, int32_t xcur, int32_t ycur, int32_t deltax, int32_t deltay);
+static int32_t  TexelDraw_Arbitrary(madam_ctx_t *ctx_, uint16_t CURPIX, uint16_t LAMV, int32_t xA, int32_t yA, int32_t xB, int32_t yB, int32_t xC, int32_t yC, int32_t xD, int32_t yD);
+static void     DrawPackedCel_New(madam_ctx_t *ctx_);
+static void     DrawLiteralCel_New(madam_ctx_t *ctx_);
+static void     DrawLRCel_New(madam_ctx_t *ctx_);
+static void     madam_pixel_pipeline_select(madam_ctx_t *ctx_);
 static void     HandleDMA8(void);
 static void     DMAPBus(void);
 
@@ -471,37 +494,142 @@ static void     DMAPBus(void);
 #define INT1220(a)   ((int32_t)(a)>>20)
 #define INT1220up(a) ((int32_t)((a)+(1<<19))>>20)
 
-static struct
+struct madam_cache_s;
+
+typedef uint32_t (*pdec_func_t)(madam_ctx_t *ctx_, const uint32_t pixel_, uint16_t *amv_);
+typedef uint32_t (*pproc_func_t)(madam_ctx_t *ctx_, const uint32_t pdec_output_, const uint32_t fpix_, const uint32_t amv_);
+
+struct pdec_s
 {
-  uint32_t plutaCCBbits;
-  uint32_t pixelBitsMask;
-  int      tmask;
-} pdec;
+  pdec_func_t                 decode;
+  const uint16_t             *plut;
+  uint32_t                    plutaCCBbits;
+  uint32_t                    pixelBitsMask;
+  int                         tmask;
+  const struct madam_cache_s *cache;
+};
+
+struct pproc_s
+{
+  pproc_func_t process;
+  uint32_t     blank;
+  bool_t       fbread;
+};
 
-static struct
+struct pproj_s
 {
   uint32_t pmode;
   uint32_t pmodeORmask;
   uint32_t pmodeANDmask;
+  uint32_t pprocMask;
+  uint32_t VH[4];
   int      Transparent;
-} pproj;
+};
 
 static uint8_t  *DRAM;
 static uint32_t  retuval;
 static uint32_t  BITADDR;
-static uint32_t  CCBFLAGS;
-static uint32_t  PIXC;
-static uint32_t  PRE0;
-static uint32_t  PRE1;
 static uint32_t  TARGETPROJ;
-static uint32_t  SRCDATA;
-static int32_t   SPRWI;
-static int32_t   SPRHI;
 static uint32_t  PLUTF;
 static uint32_t  PDATF;
 static uint32_t  NCCBF;
-static uint32_t  PXOR1;
-static uint32_t  PXOR2;
+
+/*
+  Lines of the target a context draws, set per band by
+  opera_madam_tiles.ic. Every line is drawn otherwise. band.sequence
+  is set while a cel is only being recorded: nothing is drawn and
+  only the last row is run, which leaves XPOS, YPOS, HDX and HDY as
+  drawing the whole cel would. band.job is set while a recorded cel
+  is drawn for a band.
+*/
+#if THREADED_MADAM
+struct band_s
+{
+  int32_t y0;
+  int32_t y1;
+  bool_t  sequence;
+  bool_t  job;
+};
+#endif
+
+struct madam_stats_s
+{
+  uint64_t culled;
+  uint64_t texels;
+  uint64_t transparent;
+  uint64_t clipped;
+  uint64_t clipped_rows;
+  uint64_t pixels;
+};
+
+/*
+  Everything the cel engine keeps while drawing a cel. The emulation
+  thread draws with g_madam_ctx and each thread of
+  opera_madam_tiles.ic with its own, handed down the draw path.
+*/
+struct madam_ctx_s
+{
+  struct BitReaderBig  bitoper;
+  struct pdec_s        pdec;
+  struct pproc_s       pproc;
+  struct pproj_s       pproj;
+#if THREADED_MADAM
+  struct band_s        band;
+#endif
+  struct madam_stats_s stats;
+
+  /* packed row readers of the decoded cel cache */
+  const uint8_t       *prun;
+  const uint32_t      *ppix;
+
+  uint32_t             CCBFLAGS;
+  uint32_t             PIXC;
+  uint32_t             PRE0;
+  uint32_t             PRE1;
+  uint32_t             SRCDATA;
+  int32_t              SPRWI;
+  int32_t              SPRHI;
+  uint32_t             PXOR1;
+  uint32_t             PXOR2;
+
+  uint32_t             bpp;
+  int32_t              pixcount;
+  uint32_t             type;
+  uint32_t             offsetl;
+  uint32_t             offset;
+  uint32_t             eor;
+  int32_t              nrows;
+
+  int32_t              HDDX1616;
+  int32_t              HDDY1616;
+  int32_t              HDX1616;
+  int32_t              HDY1616;
+  int32_t              VDX1616;
+  int32_t              VDY1616;
+  int32_t              XPOS1616;
+  int32_t              YPOS1616;
+  uint32_t             CEL_ORIGIN_VH_VALUE;
+  int8_t               TEXEL_FUN_NUMBER;
+  int32_t              TEXTURE_WI_START;
+  int32_t              TEXTURE_HI_START;
+  int32_t              TEXEL_INCX;
+  int32_t              TEXEL_INCY;
+  int32_t              TEXTURE_WI_LIM;
+  int32_t              TEXTURE_HI_LIM;
+};
+
+static madam_ctx_t g_madam_ctx;
+
+static
+void
+madam_ctx_init(madam_ctx_t *ctx_)
+{
+  memset(ctx_,0,sizeof(madam_ctx_t));
+#if THREADED_MADAM
+  ctx_->band.y0 = INT32_MIN;
+  ctx_->band.y1 = INT32_MAX;
+#endif
+}
 
 static uint32_t const BPP[8] = {1,1,2,4,6,8,16,1};
 
@@ -511,14 +639,6 @@ static uint16_t MAPu8b[256+64];
 static uint16_t MAPc8bAMV[256+64];
 static uint16_t MAPc16bAMV[8*8*8+64];
 
-static uint32_t bpp;
-static int32_t  pixcount;
-static uint32_t type;
-static uint32_t offsetl;
-static uint32_t offset;
-static uint32_t eor;
-static int32_t  nrows;
-
 //CelEngine STATBits
 #define STATBITS	MADAM.mregs[0x28]
 
@@ -602,6 +722,17 @@ opera_madam_peek(uint32_t addr_)
   return MADAM.mregs[addr_];
 }
 
+/*
+  Matrix engine
+
+  Each command multiplies a single vector and the ARM stores every
+  operand and loads every result through the MADAM registers, so the
+  register traffic rather than the arithmetic sets the cost. The sums
+  are left to scalar int64 math: mirroring the operands for the SIMD
+  kernels of opera_fixedpoint_math costs more per store than it saves
+  per multiply.
+*/
+
 /* Matrix engine macros */
 /* input */
 #define MI00 ((int64_t)(int32_t)MADAM.mregs[0x600])
@@ -746,6 +877,10 @@ opera_madam_poke(uint32_t addr_,
       return;
    }
 
+   /* a pending async cel list is drawn with the target registers */
+   if((addr_ >= 0x130) && (addr_ <= 0x13C))
+      opera_madam_sync();
+
    switch(addr_)
    {
       case 0x00:
@@ -767,6 +902,7 @@ opera_madam_poke(uint32_t addr_,
             MADAM.FSM = FSM_INPROCESS;
          return;
       case SPRSTOP:
+         opera_madam_sync();
          MADAM.FSM = FSM_IDLE;
          NEXTCCB = 0;
          return;
@@ -775,6 +911,7 @@ opera_madam_poke(uint32_t addr_,
             MADAM.FSM = FSM_INPROCESS;
          return;
       case SPRPAUS:
+         opera_madam_sync();
          if(MADAM.FSM == FSM_INPROCESS)
             MADAM.FSM = FSM_SUSPENDED;
          return;
@@ -827,256 +964,1211 @@ opera_madam_poke(uint32_t addr_,
 
 static uint32_t Flag;
 
-static float HDDX;
-static float HDDY;
-static float HDX;
-static float HDY;
-static float VDX;
-static float VDY;
-
-static int32_t  HDDX1616;
-static int32_t  HDDY1616;
-static int32_t  HDX1616;
-static int32_t  HDY1616;
-static int32_t  VDX1616;
-static int32_t  VDY1616;
-static int32_t  XPOS1616;
-static int32_t  YPOS1616;
-static int32_t  HDX1616_2;
-static int32_t  HDY1616_2;
-static uint32_t CEL_ORIGIN_VH_VALUE;
-static int8_t   TEXEL_FUN_NUMBER;
-static int32_t  TEXTURE_WI_START;
-static int32_t  TEXTURE_HI_START;
-static int32_t  TEXEL_INCX;
-static int32_t  TEXEL_INCY;
-static int32_t  TEXTURE_WI_LIM;
-static int32_t  TEXTURE_HI_LIM;
+static int32_t HDX1616_2;
+static int32_t HDY1616_2;
 
+#if THREADED_MADAM
 static
-void
-LoadPLUT(uint32_t pnt_,
-         int32_t  n_)
+INLINE
+bool_t
+madam_band_test(madam_ctx_t   *ctx_,
+                const int32_t  y_)
 {
-  int i;
+  return ((y_ >= ctx_->band.y0) && (y_ < ctx_->band.y1));
+}
 
-  for(i = 0; i < n_; i++)
-    {
-#ifdef MSB_FIRST
-      MADAM.PLUT[i] = opera_mem_read16((((pnt_ >> 1) + i)) << 1);
+/* y0_ to y1_ are the lines the row can touch, inclusive */
+static
+INLINE
+bool_t
+madam_band_skip_row(madam_ctx_t   *ctx_,
+                    const int32_t  y0_,
+                    const int32_t  y1_,
+                    const bool_t   last_)
+{
+  if(ctx_->band.sequence)
+    return !last_;
+
+  return ((y1_ < ctx_->band.y0) || (y0_ >= ctx_->band.y1));
+}
+
+/* TexelDraw_Arbitrary() lines are in hires units */
+static
+INLINE
+void
+madam_band_clamp(madam_ctx_t *ctx_,
+                 int32_t     *y0_,
+                 int32_t     *y1_)
+{
+  int64_t y0;
+  int64_t y1;
+
+  y0 = ((int64_t)ctx_->band.y0 << HIRESMODE);
+  y1 = ((int64_t)ctx_->band.y1 << HIRESMODE);
+  if(*y0_ < y0)
+    *y0_ = y0;
+  if(*y1_ > y1)
+    *y1_ = y1;
+}
 #else
-      MADAM.PLUT[i] = opera_mem_read16((((pnt_ >> 1) + i)^1) << 1);
-#endif
-    }
+static
+INLINE
+bool_t
+madam_band_test(madam_ctx_t   *ctx_,
+                const int32_t  y_)
+{
+  return TRUE;
+}
+
+static
+INLINE
+bool_t
+madam_band_skip_row(madam_ctx_t   *ctx_,
+                    const int32_t  y0_,
+                    const int32_t  y1_,
+                    const bool_t   last_)
+{
+  return FALSE;
 }
 
+static
+INLINE
 void
-opera_madam_cel_handle(void)
+madam_band_clamp(madam_ctx_t *ctx_,
+                 int32_t     *y0_,
+                 int32_t     *y1_)
 {
-  STATBITS |= SPRON;
-  Flag = 0;
 
-  while((NEXTCCB != 0) && (!Flag))
-    //if(MADAM.FSM==FSM_INPROCESS)
+}
+#endif
+
+/* a line mapped row runs from ycur_ towards HDY */
+static
+INLINE
+bool_t
+madam_band_skip_line_row(madam_ctx_t   *ctx_,
+                         const int32_t  ycur_,
+                         const bool_t   last_)
+{
+  return madam_band_skip_row(ctx_,((ctx_->HDY1616 < 0) ? INT32_MIN : (ycur_ >> 16)),
+                             ((ctx_->HDY1616 > 0) ? INT32_MAX : (ycur_ >> 16)),
+                             last_);
+}
+
+/* with HDY 0 a scale mapped row covers ycur_ to ycur_ + dy_ */
+static
+INLINE
+bool_t
+madam_band_skip_scale_row(madam_ctx_t   *ctx_,
+                          const int32_t  ycur_,
+                          const int32_t  dy_,
+                          const bool_t   last_)
+{
+  int32_t y0;
+  int32_t y1;
+
+  if(ctx_->HDY1616 || (FIXMODE & FIX_BIT_TIMING_3))
+    return madam_band_skip_row(ctx_,INT32_MIN,INT32_MAX,last_);
+
+  y0 = (ycur_ >> 16);
+  y1 = ((ycur_ + dy_) >> 16);
+
+  return madam_band_skip_row(ctx_,((y0 < y1) ? y0 : y1),
+                             ((y0 < y1) ? y1 : y0),
+                             last_);
+}
+
+/*
+  An arbitrary mapped row of n_ texels lies between its top edge and
+  that of the next row, HDY has already been stepped to the latter.
+*/
+static
+INLINE
+bool_t
+madam_band_skip_quad_row(madam_ctx_t   *ctx_,
+                         const int32_t  ycur_,
+                         const int32_t  hdy_,
+                         const int32_t  ydown_,
+                         const int32_t  n_,
+                         const bool_t   last_)
+{
+  int     i;
+  int64_t y[4];
+  int64_t y0;
+  int64_t y1;
+
+  y[0] = ycur_;
+  y[1] = (ycur_ + ((int64_t)hdy_ * n_));
+  y[2] = ydown_;
+  y[3] = (ydown_ + ((int64_t)ctx_->HDY1616 * n_));
+
+  y0 = y1 = y[0];
+  for(i = 1; i < 4; i++)
     {
-      if((NEXTCCB == 0) || (Flag))
-        {
-          MADAM.FSM = FSM_IDLE;
-          return;
-        }
+      if(y[i] < y0)
+        y0 = y[i];
+      if(y[i] > y1)
+        y1 = y[i];
+    }
 
-      //1st step -- parce CCB and load it into registers
-      CURRENTCCB = (NEXTCCB & 0x00FFFFFC);
-      if((CURRENTCCB >> 20) > 2)
-        {
-          MADAM.FSM = FSM_IDLE;
-          return;
-        }
+  if((y0 < INT32_MIN) || (y1 > INT32_MAX))
+    return madam_band_skip_row(ctx_,INT32_MIN,INT32_MAX,last_);
 
-      CCBFLAGS    = mread32(CURRENTCCB);
-      CURRENTCCB += 4;
+  return madam_band_skip_row(ctx_,((y0 >> 16) - 1),((y1 >> 16) + 1),last_);
+}
 
-      if(CCBFLAGS & CCB_PXOR)
-        {
-          PXOR1 = 0;
-          PXOR2 = 0x1F1F1F1F;
-        }
-      else
-        {
-          PXOR1 = 0xFFFFFFFF;
-          PXOR2 = 0;
-        }
+/*
+  The length of a packed row isn't known before it is decoded but its
+  texels only move away from where the row starts. Once both edges
+  are past the band in that direction nothing more is drawn in it.
+  A row being sequenced is never past the band.
+*/
+static
+INLINE
+bool_t
+madam_band_passed(madam_ctx_t   *ctx_,
+                  const int32_t  ycur_,
+                  const int32_t  hdy_,
+                  const int32_t  ydown_)
+{
+  int32_t y0;
+  int32_t y1;
 
-      Flag  = 0;
-      PLUTF = 0;
-      PDATF = 0;
-      NCCBF = 0;
+  y0 = (((ycur_ < ydown_) ? ycur_ : ydown_) >> 16);
+  y1 = (((ycur_ < ydown_) ? ydown_ : ycur_) >> 16);
+  if((hdy_ >= 0) && (ctx_->HDY1616 >= 0))
+    return madam_band_skip_row(ctx_,(y0 - 1),INT32_MAX,TRUE);
+  if((hdy_ <= 0) && (ctx_->HDY1616 <= 0))
+    return madam_band_skip_row(ctx_,INT32_MIN,(y1 + 1),TRUE);
 
-      NEXTCCB = mread32(CURRENTCCB) & 0xFFFFFFFC;
+  return FALSE;
+}
 
-      if(!(CCBFLAGS & CCB_NPABS))
-        {
-          NEXTCCB += CURRENTCCB + 4;
-          NEXTCCB &= 0x00FFFFFF;
-        }
+/*
+  Statistics
+
+  Drawing counts into the thread's madam_stats while statistics or
+  cel timing are enabled and it's added to the totals after each cel
+  while statistics are, the rows and texels clip culling skipped
+  included. With the target split between threads a cel
+  is run once as it is recorded and again for every band it touches:
+  culled cels are counted on the first run and the rest on the
+  others, a row drawn by two bands counts its texels twice.
+*/
+#if THREADED_MADAM
+#define MADAM_STAT_ADD(v_,n_) __sync_fetch_and_add(&(v_),(n_))
+#else
+#define MADAM_STAT_ADD(v_,n_) ((v_) += (n_))
+#endif
 
-      if(NEXTCCB == 0)
-        NCCBF = 1;
-      if((NEXTCCB >> 20) > 2)
-        NCCBF = 1;
+static bool_t              g_madam_stats_enabled;
+static bool_t              g_madam_stats_count;
+static opera_madam_clock_t g_madam_stats_clock;
+static opera_madam_stats_t g_madam_stats;
+static bool_t              g_madam_cel_timing;
+static uint64_t            g_madam_cull_rows;
+static uint64_t            g_madam_cull_texels;
+
+/* counts per texel and pixel cost a predictable branch while disabled */
+#define MADAM_STAT_COUNT(ctx_,v_,n_)            \
+  do                                            \
+    {                                           \
+      if(g_madam_stats_count)                   \
+        (ctx_)->stats.v_ += (n_);               \
+    } while(0)
+
+#if THREADED_MADAM
+static
+INLINE
+bool_t
+madam_stats_recorded(madam_ctx_t *ctx_)
+{
+  return !ctx_->band.job;
+}
 
-      CURRENTCCB += 4;
+static
+INLINE
+bool_t
+madam_stats_drawn(madam_ctx_t *ctx_)
+{
+  return !ctx_->band.sequence;
+}
+#else
+static
+INLINE
+bool_t
+madam_stats_recorded(madam_ctx_t *ctx_)
+{
+  return TRUE;
+}
 
-      PDATA = mread32(CURRENTCCB) & 0xFFFFFFFC;
-      /*
-        if((PDATA==0))
-      	PDATF=1;
-      */
-      if(!(CCBFLAGS & CCB_SPABS))
-        {
-          PDATA += CURRENTCCB + 4;
-          PDATA &= 0x00FFFFFF;
-        }
+static
+INLINE
+bool_t
+madam_stats_drawn(madam_ctx_t *ctx_)
+{
+  return TRUE;
+}
+#endif
 
-      if((PDATA >> 20) > 2)
-        PDATF = 1;
-      CURRENTCCB += 4;
+static
+void
+madam_stats_add(madam_ctx_t    *ctx_,
+                const uint32_t  type_,
+                const uint64_t  ticks_)
+{
+  if(madam_stats_recorded(ctx_) && ctx_->stats.culled)
+    MADAM_STAT_ADD(g_madam_stats.cels_culled,ctx_->stats.culled);
 
-      if(CCBFLAGS & CCB_LDPLUT)
-        {
-          PLUTDATA = mread32(CURRENTCCB) & 0xFFFFFFFC;
-          /*
-            if((PLUTDATA == 0))
-              PLUTF=1;
-          */
-          if(!(CCBFLAGS & CCB_PPABS))
-            {
-              PLUTDATA += CURRENTCCB + 4;
-              PLUTDATA &= 0x00FFFFFF;
-            }
+  if(!madam_stats_drawn(ctx_))
+    return;
 
-          if((PLUTDATA >> 20) > 2)
-            PLUTF = 1;
-        }
+  MADAM_STAT_ADD(g_madam_stats.texels,ctx_->stats.texels);
+  MADAM_STAT_ADD(g_madam_stats.texels_transparent,ctx_->stats.transparent);
+  MADAM_STAT_ADD(g_madam_stats.texels_clipped,ctx_->stats.clipped);
+  MADAM_STAT_ADD(g_madam_stats.pixels,ctx_->stats.pixels);
+  if(ctx_->stats.clipped_rows)
+    MADAM_STAT_ADD(g_madam_cull_rows,ctx_->stats.clipped_rows);
+  if(ctx_->stats.clipped)
+    MADAM_STAT_ADD(g_madam_cull_texels,ctx_->stats.clipped);
+  if(!ctx_->stats.culled)
+    MADAM_STAT_ADD(g_madam_stats.ticks[type_][ctx_->TEXEL_FUN_NUMBER],ticks_);
+}
 
-      CURRENTCCB += 4;
+void
+opera_madam_stats_set(const int           enable_,
+                      opera_madam_clock_t clock_)
+{
+  opera_madam_sync();
 
-      if(NCCBF)
-        CCBFLAGS |= CCB_LAST;
+  g_madam_stats_enabled = !!enable_;
+  g_madam_stats_count   = (g_madam_stats_enabled || g_madam_cel_timing);
+  g_madam_stats_clock   = (enable_ ? clock_ : NULL);
+}
 
-      if(CCBFLAGS & CCB_LAST)
-        Flag = 1;
+void
+opera_madam_stats_get(opera_madam_stats_t *stats_)
+{
+  *stats_ = g_madam_stats;
+}
 
-      if(CCBFLAGS & CCB_YOXY)
-        {
-          XPOS1616 = mread32(CURRENTCCB);
-          YPOS1616 = mread32(CURRENTCCB + 4);
-        }
+void
+opera_madam_stats_reset(void)
+{
+  memset(&g_madam_stats,0,sizeof(g_madam_stats));
+}
 
-      CURRENTCCB += 8;
+/*
+  Clip culling
+
+  The corners of texel j of a scale or arbitrary mapped row lie at
+  x[k] + j * dx[k] and y[k] + j * dy[k]. Texels with every corner past
+  the same side of the clip rectangle draw nothing and form a single
+  run of columns per side which is found without walking the row.
+  TexelDraw_*() can end a row at a texel past a side it is moving
+  towards (ends[]) so leading columns are only skipped up to the
+  first of those, trailing ones always are. The draw loops keep
+  positions in 32 bits so only columns whose corners fit are culled.
+  Where the last row stops leaves XPOS or YPOS for the next cel so it
+  is never trimmed.
+*/
+#define MADAM_CULL_LEFT   0
+#define MADAM_CULL_RIGHT  1
+#define MADAM_CULL_TOP    2
+#define MADAM_CULL_BOTTOM 3
 
-      /*
-        Get the VH value for this cel. This is done in case the
-        cel later decides to use the position as the source of
-        its VH values in the projector.
-      */
-      CEL_ORIGIN_VH_VALUE = ((XPOS1616 & 0x1) | ((YPOS1616 & 0x1) << 15));
+struct madam_cull_s
+{
+  int64_t x[4];
+  int64_t dx[4];
+  int64_t y[4];
+  int64_t dy[4];
+  bool_t  ends[4];
+};
 
-      /*
-        if((CCBFLAGS&CCB_SKIP)&& debug)
-        printf("###Cel skipped!!! PDATF=%d PLUTF=%d NCCBF=%d\n",PDATF,PLUTF,NCCBF);
-      */
+static
+INLINE
+int64_t
+madam_floor_div(const int64_t a_,
+                const int64_t b_)
+{
+  return ((a_ >= 0) ? (a_ / b_) : -((b_ - 1 - a_) / b_));
+}
 
-      if(CCBFLAGS & CCB_LAST)
-        NEXTCCB = 0;
+/* narrow [*lo_,*hi_] to the columns where s_ * (p_[k] + j * d_[k]) <= m_ */
+static
+void
+madam_cull_side(const int64_t *p_,
+                const int64_t *d_,
+                const int64_t  s_,
+                const int64_t  m_,
+                int64_t       *lo_,
+                int64_t       *hi_)
+{
+  int     k;
+  int64_t j;
+  int64_t p;
+  int64_t d;
 
-      if(CCBFLAGS & CCB_LDSIZE)
+  for(k = 0; k < 4; k++)
+    {
+      p = (s_ * p_[k]);
+      d = (s_ * d_[k]);
+      if(d > 0)
         {
-          HDX1616     = ((int32_t)mread32(CURRENTCCB)) >> 4;
-          HDX         = HDX1616 / 65536.0;
-          CURRENTCCB += 4;
-          HDY1616     = ((int32_t)mread32(CURRENTCCB)) >> 4;
-          HDY         = HDY1616 / 65536.0;
-          CURRENTCCB += 4;
-          VDX1616     = mread32(CURRENTCCB);
-          VDX         = VDX1616 / 65536.0;
-          CURRENTCCB += 4;
-          VDY1616     = mread32(CURRENTCCB);
-          VDY         = VDY1616 / 65536.0;
-          CURRENTCCB += 4;
+          j = madam_floor_div(m_ - p,d);
+          if(j < *hi_)
+            *hi_ = j;
         }
-
-      if(CCBFLAGS & CCB_LDPRS)
+      else if(d < 0)
         {
-          HDDX1616    = ((int32_t)mread32(CURRENTCCB)) >> 4;
-          HDDX        = HDDX1616 / 65536.0;
-          CURRENTCCB += 4;
-          HDDY1616    = ((int32_t)mread32(CURRENTCCB)) >> 4;
-          HDDY        = HDDY1616 / 65536.0;
-          CURRENTCCB += 4;
+          j = -madam_floor_div(m_ - p,-d);
+          if(j > *lo_)
+            *lo_ = j;
         }
-
-      if(CCBFLAGS & CCB_LDPPMP)
+      else if(p > m_)
         {
-          PIXC        = mread32(CURRENTCCB);
-          CURRENTCCB += 4;
+          *hi_ = -1;
         }
+    }
+}
 
-      if(CCBFLAGS & CCB_CCBPRE)
-        {
-          PRE0        = mread32(CURRENTCCB);
-          CURRENTCCB += 4;
-          if(!(CCBFLAGS & CCB_PACKED))
+/* lowest and highest value of the lines p_ + j * d_ over [0,n_] */
+static
+void
+madam_cull_extent(const int64_t *p_,
+                  const int64_t *d_,
+                  const int64_t  n_,
+                  int64_t       *min_,
+                  int64_t       *max_)
+{
+  int     k;
+  int64_t v[2];
+
+  *min_ = *max_ = p_[0];
+  for(k = 0; k < 4; k++)
+    {
+      v[0] = p_[k];
+      v[1] = (p_[k] + (n_ * d_[k]));
+      if(v[0] < *min_)
+        *min_ = v[0];
+      if(v[1] < *min_)
+        *min_ = v[1];
+      if(v[0] > *max_)
+        *max_ = v[0];
+      if(v[1] > *max_)
+        *max_ = v[1];
+    }
+}
+
+/*
+  Columns [*j0_,*j1_) of a row of at most n_ texels which can draw
+  anything, TRUE when there are none.
+*/
+static
+bool_t
+madam_cull_columns(const struct madam_cull_s *c_,
+                   const int32_t              n_,
+                   const bool_t               last_,
+                   int32_t                   *j0_,
+                   int32_t                   *j1_)
+{
+  int     i;
+  int     k;
+  int64_t j;
+  int64_t n;
+  int64_t xr;
+  int64_t yb;
+  int64_t lo[4];
+  int64_t hi[4];
+  int64_t min[2];
+  int64_t max[2];
+  bool_t  tail;
+
+  *j0_ = 0;
+  *j1_ = n_;
+  if(last_ || (n_ <= 0))
+    return FALSE;
+
+  xr = ((int64_t)(MADAM.clipx + 1) << 16);
+  yb = ((int64_t)(MADAM.clipy + 1) << 16);
+
+  n = n_;
+  madam_cull_extent(c_->x,c_->dx,n,&min[0],&max[0]);
+  madam_cull_extent(c_->y,c_->dy,n,&min[1],&max[1]);
+  if((min[0] >= 0) && (max[0] < xr) && (min[1] >= 0) && (max[1] < yb))
+    return FALSE;
+
+  tail = TRUE;
+  if((min[0] < INT32_MIN) || (max[0] > INT32_MAX) ||
+     (min[1] < INT32_MIN) || (max[1] > INT32_MAX))
+    {
+      lo[0] = 0;
+      hi[0] = n;
+      madam_cull_side(c_->x,c_->dx, 1,INT32_MAX,&lo[0],&hi[0]);
+      madam_cull_side(c_->x,c_->dx,-1,-(int64_t)INT32_MIN,&lo[0],&hi[0]);
+      madam_cull_side(c_->y,c_->dy, 1,INT32_MAX,&lo[0],&hi[0]);
+      madam_cull_side(c_->y,c_->dy,-1,-(int64_t)INT32_MIN,&lo[0],&hi[0]);
+      if((lo[0] > 0) || (hi[0] < 1))
+        return FALSE;
+      n    = hi[0];
+      tail = FALSE;
+    }
+
+  for(k = 0; k < 4; k++)
+    {
+      lo[k] = 0;
+      hi[k] = (n - 1);
+    }
+
+  if(min[0] < 0)
+    madam_cull_side(c_->x,c_->dx, 1,-1,&lo[MADAM_CULL_LEFT],&hi[MADAM_CULL_LEFT]);
+  else
+    hi[MADAM_CULL_LEFT] = -1;
+  if(max[0] >= xr)
+    madam_cull_side(c_->x,c_->dx,-1,-xr,&lo[MADAM_CULL_RIGHT],&hi[MADAM_CULL_RIGHT]);
+  else
+    hi[MADAM_CULL_RIGHT] = -1;
+  if(min[1] < 0)
+    madam_cull_side(c_->y,c_->dy, 1,-1,&lo[MADAM_CULL_TOP],&hi[MADAM_CULL_TOP]);
+  else
+    hi[MADAM_CULL_TOP] = -1;
+  if(max[1] >= yb)
+    madam_cull_side(c_->y,c_->dy,-1,-yb,&lo[MADAM_CULL_BOTTOM],&hi[MADAM_CULL_BOTTOM]);
+  else
+    hi[MADAM_CULL_BOTTOM] = -1;
+
+  /* leading columns, up to any which could end the row */
+  j = 0;
+  for(i = 0; i < 4; i++)
+    {
+      int64_t next;
+
+      next = j;
+      for(k = 0; k < 4; k++)
+        {
+          if((lo[k] > j) || (hi[k] < j))
+            continue;
+          if(c_->ends[k])
+            {
+              next = j;
+              break;
+            }
+          if(hi[k] >= next)
+            next = (hi[k] + 1);
+        }
+
+      if(next == j)
+        break;
+
+      for(k = 0; k < 4; k++)
+        {
+          if(c_->ends[k] && (lo[k] <= hi[k]) && (lo[k] > j) && (lo[k] < next))
+            next = lo[k];
+        }
+
+      j = next;
+    }
+
+  *j0_ = (int32_t)j;
+  if(!tail)
+    return FALSE;
+
+  if(j >= n)
+    {
+      *j0_ = n_;
+      return TRUE;
+    }
+
+  /* trailing columns */
+  j = n;
+  for(i = 0; i < 4; i++)
+    {
+      for(k = 0; k < 4; k++)
+        {
+          if((lo[k] <= (j - 1)) && (hi[k] >= (j - 1)))
+            break;
+        }
+
+      if(k == 4)
+        break;
+
+      j = lo[k];
+      if(j <= *j0_)
+        {
+          *j1_ = *j0_;
+          return TRUE;
+        }
+    }
+
+  *j1_ = (int32_t)j;
+
+  return FALSE;
+}
+
+/*
+  A scale mapped texel covers xcur to xcur + HDX + VDX and ycur to
+  ycur + HDY + dy_. FIX_BIT_TIMING_3 stretches lines so those rows
+  aren't culled.
+*/
+static
+INLINE
+bool_t
+madam_cull_scale(madam_ctx_t         *ctx_,
+                 struct madam_cull_s *c_,
+                 const int32_t        xcur_,
+                 const int32_t        ycur_,
+                 const int32_t        dy_)
+{
+  int k;
+
+  if(FIXMODE & FIX_BIT_TIMING_3)
+    return FALSE;
+
+  for(k = 0; k < 4; k++)
+    {
+      c_->x[k]  = ((k & 1) ? ((int64_t)xcur_ + ctx_->HDX1616 + ctx_->VDX1616) : xcur_);
+      c_->dx[k] = ctx_->HDX1616;
+      c_->y[k]  = ((k & 1) ? ((int64_t)ycur_ + ctx_->HDY1616 + dy_) : ycur_);
+      c_->dy[k] = ctx_->HDY1616;
+    }
+
+  c_->ends[MADAM_CULL_LEFT]   = (ctx_->HDX1616 < 0);
+  c_->ends[MADAM_CULL_RIGHT]  = (ctx_->HDX1616 > 0);
+  c_->ends[MADAM_CULL_TOP]    = (ctx_->HDY1616 < 0);
+  c_->ends[MADAM_CULL_BOTTOM] = (ctx_->HDY1616 > 0);
+
+  return TRUE;
+}
+
+/* HDX and HDY have already been stepped to the next row */
+static
+INLINE
+void
+madam_cull_quad(madam_ctx_t         *ctx_,
+                struct madam_cull_s *c_,
+                const int32_t        xcur_,
+                const int32_t        ycur_,
+                const int32_t        hdx_,
+                const int32_t        hdy_,
+                const int32_t        xdown_,
+                const int32_t        ydown_)
+{
+  c_->x[0]  = xcur_;
+  c_->x[1]  = ((int64_t)xcur_ + hdx_);
+  c_->x[2]  = ((int64_t)xdown_ + ctx_->HDX1616);
+  c_->x[3]  = xdown_;
+  c_->dx[0] = c_->dx[1] = hdx_;
+  c_->dx[2] = c_->dx[3] = ctx_->HDX1616;
+  c_->y[0]  = ycur_;
+  c_->y[1]  = ((int64_t)ycur_ + hdy_);
+  c_->y[2]  = ((int64_t)ydown_ + ctx_->HDY1616);
+  c_->y[3]  = ydown_;
+  c_->dy[0] = c_->dy[1] = hdy_;
+  c_->dy[2] = c_->dy[3] = ctx_->HDY1616;
+
+  c_->ends[MADAM_CULL_LEFT]   = ((ctx_->HDX1616 < 0) && (ctx_->HDDX1616 < 0));
+  c_->ends[MADAM_CULL_RIGHT]  = ((ctx_->HDX1616 > 0) && (ctx_->HDDX1616 > 0));
+  c_->ends[MADAM_CULL_TOP]    = ((ctx_->HDY1616 < 0) && (ctx_->HDDY1616 < 0));
+  c_->ends[MADAM_CULL_BOTTOM] = ((ctx_->HDY1616 > 0) && (ctx_->HDDY1616 > 0));
+}
+
+static
+INLINE
+void
+madam_cull_count(madam_ctx_t   *ctx_,
+                 const int32_t  rows_,
+                 const int32_t  texels_)
+{
+  MADAM_STAT_COUNT(ctx_,clipped_rows,rows_);
+  MADAM_STAT_COUNT(ctx_,clipped,texels_);
+}
+
+/* a packed row of len_ bytes holds at most 64 texels per run byte */
+static
+INLINE
+int32_t
+madam_packed_row_max(madam_ctx_t   *ctx_,
+                     const int32_t  len_)
+{
+  int32_t len;
+
+  len = (len_ - (int32_t)ctx_->offsetl);
+
+  return ((len > 0) ? (len << 6) : 0);
+}
+
+void
+opera_madam_cull_stats(uint64_t *rows_,
+                       uint64_t *texels_)
+{
+  if(rows_)
+    *rows_ = g_madam_cull_rows;
+  if(texels_)
+    *texels_ = g_madam_cull_texels;
+}
+
+static
+uint32_t
+madam_target_len(void)
+{
+  return (((MADAM.clipy >> 1) * MADAM.wmod) + (MADAM.clipx << 2) + 4);
+}
+
+static
+bool_t
+madam_target_overlaps(const uint32_t addr_,
+                      const uint32_t len_)
+{
+  int      i;
+  uint32_t dst;
+  uint32_t len;
+
+  dst = REGCTL3;
+  len = madam_target_len();
+
+  for(i = 0; i < (HIRESMODE ? 4 : 1); i++)
+    {
+      if((addr_ < (dst + len)) && (dst < (addr_ + len_)))
+        return TRUE;
+      dst += (1024 * 1024);
+    }
+
+  return FALSE;
+}
+
+/*
+  The bytes from SRCDATA the current cel can read. Packed rows are
+  only found by following the row offsets and are contiguous. A row
+  offset within the target may not be written yet so the walk stops
+  there, the length then covers it. The bit reader can load a couple
+  of words past the end of a row.
+*/
+static
+uint32_t
+madam_cel_source_len(madam_ctx_t *ctx_)
+{
+  int32_t  row;
+  int32_t  rows;
+  uint32_t len;
+  uint32_t addr;
+  uint32_t stride;
+
+  rows = (((ctx_->PRE0 & PRE0_VCNT_MASK) >> PRE0_VCNT_SHIFT) + 1);
+
+  if(ctx_->CCBFLAGS & CCB_PACKED)
+    {
+      addr = ctx_->SRCDATA;
+      for(row = 0; row < rows; row++)
+        {
+          if(madam_target_overlaps(addr,4))
+            return (addr + 4 - ctx_->SRCDATA);
+
+          len = mread32(addr);
+          len = ((BPP[ctx_->PRE0 & PRE0_BPP_MASK] < 8) ? (len >> 24) : (len >> 16));
+          len = ((len + 2) << 2);
+
+          addr += len;
+        }
+
+      return (addr + 8 - ctx_->SRCDATA);
+    }
+
+  stride = ((BPP[ctx_->PRE0 & PRE0_BPP_MASK] < 8) ?
+            ((ctx_->PRE1 & PRE1_WOFFSET8_MASK)  >> PRE1_WOFFSET8_SHIFT) :
+            ((ctx_->PRE1 & PRE1_WOFFSET10_MASK) >> PRE1_WOFFSET10_SHIFT));
+  stride = ((stride + 2) << 2);
+
+  /* a row can be wider than the stride, LRFORM reads a word a pixel */
+  len  = (((ctx_->PRE1 & PRE1_TLHPCNT_MASK) + 1) + ((ctx_->PRE0 >> 24) & 0xF));
+  len  = ((len << 2) + 8);
+  len += (rows * stride);
+
+  return len;
+}
+
+/*
+  The cel engine writes straight into DRAM. Any ARM code predecoded
+  from the destination bitmap has to be decoded again and any cel
+  decoded from it checked again.
+*/
+static
+void
+madam_invalidate_target(void)
+{
+  opera_arm_decode_cache_invalidate(REGCTL3,madam_target_len());
+  opera_madam_dram_dirty(REGCTL3,madam_target_len());
+}
+
+static
+uint32_t
+madam_cel_draw_type(madam_ctx_t *ctx_)
+{
+  if(ctx_->CCBFLAGS & CCB_PACKED)
+    {
+      DrawPackedCel_New(ctx_);
+      return OPERA_MADAM_CEL_PACKED;
+    }
+
+  if((ctx_->PRE1 & PRE1_LRFORM) && (BPP[ctx_->PRE0 & PRE0_BPP_MASK] == 16))
+    {
+      DrawLRCel_New(ctx_);
+      return OPERA_MADAM_CEL_LR;
+    }
+
+  DrawLiteralCel_New(ctx_);
+
+  return OPERA_MADAM_CEL_LITERAL;
+}
+
+static
+void
+madam_cel_draw(madam_ctx_t *ctx_)
+{
+  uint32_t type;
+  uint64_t ticks;
+
+  if(!g_madam_stats_count)
+    {
+      madam_cel_draw_type(ctx_);
+      return;
+    }
+
+  memset(&ctx_->stats,0,sizeof(ctx_->stats));
+
+  ticks = (g_madam_stats_clock ? g_madam_stats_clock() : 0);
+  type  = madam_cel_draw_type(ctx_);
+  if(g_madam_stats_clock)
+    ticks = (g_madam_stats_clock() - ticks);
+
+  if(g_madam_stats_enabled)
+    madam_stats_add(ctx_,type,ticks);
+}
+
+#if THREADED_MADAM
+#include "opera_madam_tiles.ic"
+#else
+static
+INLINE
+void
+madam_tiles_begin(void)
+{
+
+}
+
+static
+INLINE
+void
+madam_tiles_sync(madam_ctx_t    *ctx_,
+                 const uint32_t  addr_,
+                 const uint32_t  len_)
+{
+
+}
+
+static
+INLINE
+void
+madam_tiles_draw(madam_ctx_t *ctx_)
+{
+  madam_cel_draw(ctx_);
+}
+
+static
+INLINE
+void
+madam_tiles_end(madam_ctx_t *ctx_)
+{
+
+}
+
+static
+INLINE
+bool_t
+madam_tiles_recording(void)
+{
+  return FALSE;
+}
+
+static
+INLINE
+void
+madam_tiles_flush(madam_ctx_t *ctx_)
+{
+
+}
+
+void
+opera_madam_threads_set(const uint32_t threads_)
+{
+
+}
+
+void
+opera_madam_async_set(const int async_)
+{
+
+}
+
+void
+opera_madam_sync(void)
+{
+
+}
+
+void
+opera_madam_sync_range(const uint32_t addr_,
+                       const uint32_t len_)
+{
+
+}
+#endif
+
+#include "opera_madam_cache.ic"
+
+/*
+  Consecutive cels mostly load the same PLUT. A load is skipped when
+  it's from where the last one was, no longer, and nothing has been
+  stored there since by the generations the cel cache keeps. A PLUT
+  the current list draws over is always loaded.
+*/
+static
+bool_t
+madam_plut_loaded(const uint32_t addr_,
+                  const uint32_t len_)
+{
+  return (g_madam_plut.valid                                            &&
+          (g_madam_plut.addr == addr_)                                  &&
+          (g_madam_plut.len >= len_)                                    &&
+          (g_madam_plut.epoch == g_madam_cache_epoch)                   &&
+          (g_madam_plut.gen == madam_cache_gen(addr_,g_madam_plut.len)) &&
+          !madam_target_overlaps(addr_,g_madam_plut.len));
+}
+
+static
+void
+LoadPLUT(uint32_t pnt_,
+         int32_t  n_)
+{
+  uint32_t len;
+#ifndef MSB_FIRST
+  int32_t  i;
+  uint16_t t;
+#endif
+
+  len = (n_ * sizeof(uint16_t));
+  if(madam_plut_loaded(pnt_,len))
+    return;
+
+  memcpy(MADAM.PLUT,&DRAM[pnt_],len);
+#ifndef MSB_FIRST
+  /* pnt_ is word aligned, each word holds its halfwords swapped */
+  for(i = 0; i < n_; i += 2)
+    {
+      t                 = MADAM.PLUT[i];
+      MADAM.PLUT[i]     = MADAM.PLUT[i + 1];
+      MADAM.PLUT[i + 1] = t;
+    }
+#endif
+
+  g_madam_plut.hashed = FALSE;
+  g_madam_plut.valid  = ((pnt_ + len) <= MADAM_CACHE_END);
+  if(!g_madam_plut.valid)
+    return;
+
+  g_madam_plut.addr  = pnt_;
+  g_madam_plut.len   = len;
+  g_madam_plut.epoch = g_madam_cache_epoch;
+  g_madam_plut.gen   = madam_cache_gen(pnt_,len);
+
+  opera_arm_bus_watch(pnt_,len);
+}
+
+/*
+  Cel engine timing
+
+  By default a cel list is drawn at once when it's started and takes
+  no time. With timing enabled the list is walked a slice at a time:
+  cels are drawn until their estimated time reaches
+  MADAM_CEL_SLICE_CYCLES and the engine then holds the CPU off until
+  that many cycles have passed before the next slice, the walk
+  resuming from NEXTCCB. Video, timers and the DSP carry on meanwhile
+  so a long list is spread over the frame and into the next rather
+  than stalling one step of it. The CPU still takes FIQs while held
+  and can pause or stop the engine from the handler with SPRPAUS or
+  SPRSTOP. A cel is never split.
+
+  MADAM runs at twice the CPU clock and is taken to read a texel or
+  write a pixel a clock, plus the CCB. Cels recorded for the MADAM
+  threads aren't drawn as they're walked so the list is drawn at once
+  then as well. The hold isn't saved in save states.
+*/
+#define MADAM_CEL_CCB_CYCLES   8
+#define MADAM_CEL_SLICE_CYCLES 1024
+
+static int32_t g_madam_cel_hold;
+
+static
+int32_t
+madam_cel_cycles(madam_ctx_t *ctx_)
+{
+  return (int32_t)((ctx_->stats.texels + ctx_->stats.pixels) >> 1);
+}
+
+void
+opera_madam_cel_timing_set(const int enable_)
+{
+  opera_madam_sync();
+
+  g_madam_cel_timing  = !!enable_;
+  g_madam_stats_count = (g_madam_stats_enabled || g_madam_cel_timing);
+  g_madam_cel_hold    = 0;
+}
+
+int
+opera_madam_cel_held(void)
+{
+  return (g_madam_cel_hold > 0);
+}
+
+int32_t
+opera_madam_cel_hold(const int32_t cycles_)
+{
+  int32_t cycles;
+
+  cycles = ((g_madam_cel_hold < cycles_) ? g_madam_cel_hold : cycles_);
+
+  g_madam_cel_hold -= cycles;
+
+  return cycles;
+}
+
+void
+opera_madam_cel_handle(void)
+{
+  bool_t       timed;
+  int32_t      cycles;
+  madam_ctx_t *ctx_;
+
+  ctx_ = &g_madam_ctx;
+
+  STATBITS |= SPRON;
+  Flag = 0;
+
+  madam_tiles_begin();
+
+  timed  = (g_madam_cel_timing && !madam_tiles_recording());
+  cycles = 0;
+  while((NEXTCCB != 0) && (!Flag) && (!timed || (cycles < MADAM_CEL_SLICE_CYCLES)))
+    //if(MADAM.FSM==FSM_INPROCESS)
+    {
+      if((NEXTCCB == 0) || (Flag))
+        {
+          MADAM.FSM = FSM_IDLE;
+          break;
+        }
+
+      //1st step -- parce CCB and load it into registers
+      CURRENTCCB = (NEXTCCB & 0x00FFFFFC);
+      if((CURRENTCCB >> 20) > 2)
+        {
+          MADAM.FSM = FSM_IDLE;
+          break;
+        }
+
+      madam_tiles_sync(ctx_,CURRENTCCB,MADAM_CCB_MAX);
+
+      ctx_->CCBFLAGS = mread32(CURRENTCCB);
+      CURRENTCCB    += 4;
+      cycles        += MADAM_CEL_CCB_CYCLES;
+
+      if(g_madam_stats_enabled)
+        {
+          g_madam_stats.cels++;
+          if(ctx_->CCBFLAGS & CCB_SKIP)
+            g_madam_stats.cels_skipped++;
+        }
+
+      if(ctx_->CCBFLAGS & CCB_PXOR)
+        {
+          ctx_->PXOR1 = 0;
+          ctx_->PXOR2 = 0x1F1F1F1F;
+        }
+      else
+        {
+          ctx_->PXOR1 = 0xFFFFFFFF;
+          ctx_->PXOR2 = 0;
+        }
+
+      Flag  = 0;
+      PLUTF = 0;
+      PDATF = 0;
+      NCCBF = 0;
+
+      NEXTCCB = mread32(CURRENTCCB) & 0xFFFFFFFC;
+
+      if(!(ctx_->CCBFLAGS & CCB_NPABS))
+        {
+          NEXTCCB += CURRENTCCB + 4;
+          NEXTCCB &= 0x00FFFFFF;
+        }
+
+      if(NEXTCCB == 0)
+        NCCBF = 1;
+      if((NEXTCCB >> 20) > 2)
+        NCCBF = 1;
+
+      CURRENTCCB += 4;
+
+      PDATA = mread32(CURRENTCCB) & 0xFFFFFFFC;
+      /*
+        if((PDATA==0))
+      	PDATF=1;
+      */
+      if(!(ctx_->CCBFLAGS & CCB_SPABS))
+        {
+          PDATA += CURRENTCCB + 4;
+          PDATA &= 0x00FFFFFF;
+        }
+
+      if((PDATA >> 20) > 2)
+        PDATF = 1;
+      CURRENTCCB += 4;
+
+      if(ctx_->CCBFLAGS & CCB_LDPLUT)
+        {
+          PLUTDATA = mread32(CURRENTCCB) & 0xFFFFFFFC;
+          /*
+            if((PLUTDATA == 0))
+              PLUTF=1;
+          */
+          if(!(ctx_->CCBFLAGS & CCB_PPABS))
+            {
+              PLUTDATA += CURRENTCCB + 4;
+              PLUTDATA &= 0x00FFFFFF;
+            }
+
+          if((PLUTDATA >> 20) > 2)
+            PLUTF = 1;
+        }
+
+      CURRENTCCB += 4;
+
+      if(NCCBF)
+        ctx_->CCBFLAGS |= CCB_LAST;
+
+      if(ctx_->CCBFLAGS & CCB_LAST)
+        Flag = 1;
+
+      if(ctx_->CCBFLAGS & CCB_YOXY)
+        {
+          ctx_->XPOS1616 = mread32(CURRENTCCB);
+          ctx_->YPOS1616 = mread32(CURRENTCCB + 4);
+        }
+
+      CURRENTCCB += 8;
+
+      /*
+        Get the VH value for this cel. This is done in case the
+        cel later decides to use the position as the source of
+        its VH values in the projector.
+      */
+      ctx_->CEL_ORIGIN_VH_VALUE = ((ctx_->XPOS1616 & 0x1) | ((ctx_->YPOS1616 & 0x1) << 15));
+
+      /*
+        if((CCBFLAGS&CCB_SKIP)&& debug)
+        printf("###Cel skipped!!! PDATF=%d PLUTF=%d NCCBF=%d\n",PDATF,PLUTF,NCCBF);
+      */
+
+      if(ctx_->CCBFLAGS & CCB_LAST)
+        NEXTCCB = 0;
+
+      if(ctx_->CCBFLAGS & CCB_LDSIZE)
+        {
+          ctx_->HDX1616 = ((int32_t)mread32(CURRENTCCB)) >> 4;
+          CURRENTCCB   += 4;
+          ctx_->HDY1616 = ((int32_t)mread32(CURRENTCCB)) >> 4;
+          CURRENTCCB   += 4;
+          ctx_->VDX1616 = mread32(CURRENTCCB);
+          CURRENTCCB   += 4;
+          ctx_->VDY1616 = mread32(CURRENTCCB);
+          CURRENTCCB   += 4;
+        }
+
+      if(ctx_->CCBFLAGS & CCB_LDPRS)
+        {
+          ctx_->HDDX1616 = ((int32_t)mread32(CURRENTCCB)) >> 4;
+          CURRENTCCB    += 4;
+          ctx_->HDDY1616 = ((int32_t)mread32(CURRENTCCB)) >> 4;
+          CURRENTCCB    += 4;
+        }
+
+      if(ctx_->CCBFLAGS & CCB_LDPPMP)
+        {
+          ctx_->PIXC  = mread32(CURRENTCCB);
+          CURRENTCCB += 4;
+        }
+
+      if(ctx_->CCBFLAGS & CCB_CCBPRE)
+        {
+          ctx_->PRE0  = mread32(CURRENTCCB);
+          CURRENTCCB += 4;
+          if(!(ctx_->CCBFLAGS & CCB_PACKED))
             {
-              PRE1        = mread32(CURRENTCCB);
+              ctx_->PRE1  = mread32(CURRENTCCB);
               CURRENTCCB += 4;
             }
         }
       else if(!PDATF)
         {
-          PRE0   = mread32(PDATA);
-          PDATA += 4;
-          if(!(CCBFLAGS & CCB_PACKED))
+          madam_tiles_sync(ctx_,PDATA,8);
+          ctx_->PRE0 = mread32(PDATA);
+          PDATA     += 4;
+          if(!(ctx_->CCBFLAGS & CCB_PACKED))
             {
-              PRE1   = mread32(PDATA);
-              PDATA += 4;
+              ctx_->PRE1 = mread32(PDATA);
+              PDATA     += 4;
             }
         }
 
       /* PDEC data compute */
       {
         /* pdec.mode = PRE0 & PRE0_BPP_MASK; */
-        switch(PRE0 & PRE0_BPP_MASK)
+        switch(ctx_->PRE0 & PRE0_BPP_MASK)
           {
           case 0:
           case 7:
             continue;
           case 1:
-            pdec.plutaCCBbits  = ((CCBFLAGS & 0x0F) * 4);
-            pdec.pixelBitsMask = 1; /* 1 bit */
+            ctx_->pdec.plutaCCBbits  = ((ctx_->CCBFLAGS & 0x0F) * 4);
+            ctx_->pdec.pixelBitsMask = 1; /* 1 bit */
             break;
           case 2:
-            pdec.plutaCCBbits  = ((CCBFLAGS & 0x0E) * 4);
-            pdec.pixelBitsMask = 3; /* 2 bit */
+            ctx_->pdec.plutaCCBbits  = ((ctx_->CCBFLAGS & 0x0E) * 4);
+            ctx_->pdec.pixelBitsMask = 3; /* 2 bit */
             break;
           case 3:
           default:
-            pdec.plutaCCBbits  = ((CCBFLAGS & 0x08) * 4);
-            pdec.pixelBitsMask = 15; /* 4 bit */
+            ctx_->pdec.plutaCCBbits  = ((ctx_->CCBFLAGS & 0x08) * 4);
+            ctx_->pdec.pixelBitsMask = 15; /* 4 bit */
             break;
           }
 
-        pdec.tmask = !(CCBFLAGS & CCB_BGND);
+        ctx_->pdec.tmask = !(ctx_->CCBFLAGS & CCB_BGND);
+        ctx_->pdec.plut  = MADAM.PLUT;
+
+        ctx_->pproj.pmode        = (ctx_->CCBFLAGS & CCB_POVER_MASK);
+        ctx_->pproj.pmodeORmask  = ((ctx_->pproj.pmode == PMODE_ONE ) ? 0x8000 : 0x0000);
+        ctx_->pproj.pmodeANDmask = ((ctx_->pproj.pmode != PMODE_ZERO) ? 0xFFFF : 0x7FFF);
 
-        pproj.pmode        = (CCBFLAGS & CCB_POVER_MASK);
-        pproj.pmodeORmask  = ((pproj.pmode == PMODE_ONE ) ? 0x8000 : 0x0000);
-        pproj.pmodeANDmask = ((pproj.pmode != PMODE_ZERO) ? 0xFFFF : 0x7FFF);
+        madam_pixel_pipeline_select(ctx_);
       }
 
       /* load PLUT */
-      if((CCBFLAGS & CCB_LDPLUT) && !PLUTF)
+      if((ctx_->CCBFLAGS & CCB_LDPLUT) && !PLUTF)
         {
-          switch(PRE0 & PRE0_BPP_MASK)
+          madam_tiles_sync(ctx_,PLUTDATA,(MADAM_PLUT_COUNT * 2));
+          switch(ctx_->PRE0 & PRE0_BPP_MASK)
             {
             case 1:
               LoadPLUT(PLUTDATA,2);
@@ -1094,28 +2186,28 @@ opera_madam_cel_handle(void)
 
       /*
         CCB decoded -- let's print out our current status
-        step#2 -- getting CEL data
-      */
-      if(!(CCBFLAGS & CCB_SKIP) && !PDATF)
-        {
-          if(CCBFLAGS & CCB_PACKED)
-            {
-              DrawPackedCel_New();
-            }
-          else
-            {
-              if((PRE1 & PRE1_LRFORM) && (BPP[PRE0 & PRE0_BPP_MASK] == 16))
-                DrawLRCel_New();
-              else
-                DrawLiteralCel_New();
-            }
-
+        step#2 -- getting CEL data
+      */
+      if(!(ctx_->CCBFLAGS & CCB_SKIP) && !PDATF)
+        {
+          ctx_->SRCDATA = PDATA;
+          madam_cache_select(ctx_);
+          madam_tiles_draw(ctx_);
+          PDATA = ctx_->SRCDATA;
+          if(timed)
+            cycles += madam_cel_cycles(ctx_);
         }
     }
 
   /* STATBITS &= ~SPRON; */
   if((NEXTCCB == 0) || (Flag))
     MADAM.FSM = FSM_IDLE;
+
+  madam_tiles_end(ctx_);
+  madam_invalidate_target();
+
+  if(timed)
+    g_madam_cel_hold = cycles;
 }
 
 static
@@ -1179,11 +2271,10 @@ opera_madam_init(uint8_t *mem_)
   int32_t n;
 
   opera_madam_reset();
+  madam_ctx_init(&g_madam_ctx);
 
   DRAM = mem_;
 
-  bitoper.bitset = 1;
-
   MADAM.FSM = FSM_IDLE;
 
   MADAM.mregs[0] = ((ME_MODE == ME_MODE_HARDWARE) ?
@@ -1268,175 +2359,154 @@ mread16(const uint32_t addr_)
 #endif
 }
 
+/*
+  Pixel decoders
+
+  One per PRE0 bit depth and coding, picked per CCB by
+  madam_pixel_pipeline_select(). Each returns the decoded pixel, the
+  AMV through amv_ and flags transparent pixels for the caller.
+*/
+static
+INLINE
+void
+pdec_texel(madam_ctx_t    *ctx_,
+           const uint32_t  pixel_)
+{
+  ctx_->pproj.Transparent = (((pixel_ & 0x7FFF) == 0x0) & ctx_->pdec.tmask);
+
+  MADAM_STAT_COUNT(ctx_,texels,1);
+  MADAM_STAT_COUNT(ctx_,transparent,ctx_->pproj.Transparent);
+}
+
 static
 uint32_t
-PDEC(const uint32_t  pixel_,
-     uint16_t       *amv_)
+pdec_plut_coded(madam_ctx_t    *ctx_,
+                const uint32_t  pixel_,
+                uint16_t       *amv_)
 {
-  pdeco_t pix1;
-  uint16_t resamv;
+  uint16_t pres;
+
+  pres  = ctx_->pdec.plut[(ctx_->pdec.plutaCCBbits + ((pixel_ & ctx_->pdec.pixelBitsMask) * 2)) >> 1];
+  *amv_ = 0x49;
+
+  pdec_texel(ctx_,pres);
+
+  return pres;
+}
+
+static
+uint32_t
+pdec_6bpp(madam_ctx_t    *ctx_,
+          const uint32_t  pixel_,
+          uint16_t       *amv_)
+{
+  pdeco_t  pix1;
   uint16_t pres;
 
   pix1.raw = pixel_;
 
-  switch(PRE0 & PRE0_BPP_MASK)
-    {
-    default:
-    case 1: /* 1 bit  */
-    case 2: /* 2 bits */
-    case 3: /* 4 bits */
-      pres   = MADAM.PLUT[(pdec.plutaCCBbits + ((pix1.raw & pdec.pixelBitsMask) * 2)) >> 1];
-      resamv = 0x49;
-      break;
+  /* pmode = pix1.c6b.pw; ??? */
+  pres  = ctx_->pdec.plut[pix1.c6b.c];
+  pres  = (pres & 0x7FFF) + (pix1.c6b.pw << 15);
+  *amv_ = 0x49;
 
-    case 4:   /* 6 bits */
-      /* pmode = pix1.c6b.pw; ??? */
-      pres   = MADAM.PLUT[pix1.c6b.c];
-      pres   = (pres & 0x7FFF) + (pix1.c6b.pw << 15);
-      resamv = 0x49;
-      break;
+  pdec_texel(ctx_,pres);
 
-    case 5:   /* 8 bits */
-      if(PRE0 & PRE0_LINEAR)    /* uncoded 8 bit CEL */
-        {
-          pres   = MAPu8b[pix1.raw & 0xFF];
-          resamv = 0x49;
-        }
-      else                      /* coded 8 bit CEL */
-        {
-          pres   = MADAM.PLUT[pix1.c8b.c];
-          resamv = MAPc8bAMV[pix1.raw & 0xFF];
-        }
-      break;
+  return pres;
+}
 
-    case 6:  /* 16 bits */
-    case 7:
-      if(PRE0 & PRE0_LINEAR)    /* uncoded 16 bit CEL */
-        {
-          pres   = pix1.raw;
-          resamv = 0x49;
-        }
-      else                      /* coded 16 bit CEL */
-        {
-          pres   = MADAM.PLUT[pix1.c16b.c];
-          pres   = ((pres & 0x7FFF) | (pixel_ & 0x8000));
-          resamv = MAPc16bAMV[(pix1.raw >> 5) & 0x1FF];
-        }
+static
+uint32_t
+pdec_8bpp_linear(madam_ctx_t    *ctx_,
+                 const uint32_t  pixel_,
+                 uint16_t       *amv_)
+{
+  uint16_t pres;
 
-      break;
-    }
+  pres  = MAPu8b[pixel_ & 0xFF];
+  *amv_ = 0x49;
 
-  *amv_ = resamv;
+  pdec_texel(ctx_,pres);
 
-  /* conceptual end of decoder */
+  return pres;
+}
 
-  /*
-    TODO: Do PROJECTOR functions now?
-    They'll be done before using the PROCESSOR.
+static
+uint32_t
+pdec_8bpp_coded(madam_ctx_t    *ctx_,
+                const uint32_t  pixel_,
+                uint16_t       *amv_)
+{
+  pdeco_t  pix1;
+  uint16_t pres;
 
-    if(!(PRE1&PRE1_NOSWAP) && (CCBCTL0&(1<<27)))
-      pres = (pres&0x7ffe)|((pres&0x8000)>>15)|((pres&1)<<15);
+  pix1.raw = pixel_;
 
-    if(!(CCBCTL0 & 0x80000000))
-      pres = (pres&0x7fff)|((CCBCTL0>>15)&0x8000);
+  pres  = ctx_->pdec.plut[pix1.c8b.c];
+  *amv_ = MAPc8bAMV[pix1.raw & 0xFF];
 
-    pres=(pres|pdec.pmodeORmask)&pdec.pmodeANDmask;
-  */
+  pdec_texel(ctx_,pres);
+
+  return pres;
+}
+
+static
+uint32_t
+pdec_16bpp_linear(madam_ctx_t    *ctx_,
+                  const uint32_t  pixel_,
+                  uint16_t       *amv_)
+{
+  uint16_t pres;
+
+  pres  = pixel_;
+  *amv_ = 0x49;
 
-  pproj.Transparent = (((pres & 0x7FFF) == 0x0) & pdec.tmask);
+  pdec_texel(ctx_,pres);
 
   return pres;
 }
 
 static
 uint32_t
-PPROJ_OUTPUT(uint32_t pdec_output_,
-             uint32_t pproc_output_,
-             uint32_t pframe_input_)
+pdec_16bpp_coded(madam_ctx_t    *ctx_,
+                 const uint32_t  pixel_,
+                 uint16_t       *amv_)
 {
-  int32_t  b15mode;
-  int32_t  b0mode;
-  uint32_t VHOutput;
+  pdeco_t  pix1;
+  uint16_t pres;
 
-  /*
-    CCB_PLUTPOS flag
-    Determine projector's originating source of VH values.
-  */
+  pix1.raw = pixel_;
 
-  if(CCBFLAGS & CCB_PLUTPOS) /* Use pixel decoder output. */
-    VHOutput = (pdec_output_ & 0x8001);
-  else /* Use VH values determined from the CEL's origin. */
-    VHOutput = CEL_ORIGIN_VH_VALUE;
+  pres  = ctx_->pdec.plut[pix1.c16b.c];
+  pres  = ((pres & 0x7FFF) | (pixel_ & 0x8000));
+  *amv_ = MAPc16bAMV[(pix1.raw >> 5) & 0x1FF];
 
-  /*
-    SWAPHV flag
-    Swap the H and V values now if requested.
-  */
-  if(CCBCTL0 & SWAPHV)
-    {
-      /* TODO: I have read that PRE1 is only set for unpacked CELs.
-         So... should this be ignored if using packed CELs? I don't
-         know. */
-      if(!(PRE1 & PRE1_NOSWAP))
-        VHOutput = ((VHOutput >> 15) | ((VHOutput & 1) << 15));
-    }
+  pdec_texel(ctx_,pres);
 
-#if 0
-  /*
-    CFBDSUB flag
-    Substitute the VH values from the frame buffer if requested.
-  */
-  if(CCBCTL0 & CFBDSUB)
-    {
-      /* TODO: This should be re-enabled sometime. However, it currently
-         causes the wing commander 3 movies to screw up again! There
-         must be some missing mbehavior elsewhere. */
-      VHOutput = (pframe_input & 0x8001);
-    }
-#endif
+  return pres;
+}
 
-  /*
-    B15POS_MASK settings
-    Substitute the V value explicitly if requested.
-  */
-  b15mode = (CCBCTL0 & B15POS_MASK);
-  switch(b15mode)
-    {
-    case B15POS_PDC:
-    default:
-      /* do nothing */
-      break;
-    case B15POS_0:
-      VHOutput = (VHOutput & ~0x8000);
-      break;
-    case B15POS_1:
-      VHOutput |= 0x8000;
-      break;
-    }
+/*
+  Projector
 
-  /*
-    B15POS_MASK settings
-    Substitute the H value explicitly if requested.
-  */
-  b0mode = (CCBCTL0 & B0POS_MASK);
-  switch(b0mode)
-    {
-    case B0POS_PDC:
-      /* do nothing  */
-      break;
-    case B0POS_PPMP:
-      /* Use LSB from pixel processor output. */
-      VHOutput = ((VHOutput & ~0x1) | (pproc_output_ & 0x1));
-      break;
-    case B0POS_0:
-      VHOutput = (VHOutput & ~0x1);
-      break;
-    case B0POS_1:
-      VHOutput |= 0x01;
-      break;
-    }
+  The VH bits only depend on bits 15 and 0 of the decoder output and
+  on state which is fixed for the whole cel (CCB_PLUTPOS, SWAPHV,
+  PRE1_NOSWAP, B15POS and B0POS) so they are resolved once per CCB
+  into pproj.VH. B0POS_PPMP passes bit 0 of the processor output
+  through pproj.pprocMask.
 
-  return ((pproc_output_ & 0x7FFE) | VHOutput);
+  CFBDSUB would substitute the VH values from the frame buffer but
+  it's left off: it breaks the Wing Commander 3 movies.
+*/
+static
+FORCEINLINE
+uint32_t
+PPROJ_OUTPUT(madam_ctx_t    *ctx_,
+             const uint32_t  pdec_output_,
+             const uint32_t  pproc_output_)
+{
+  return ((pproc_output_ & ctx_->pproj.pprocMask) |
+          ctx_->pproj.VH[((pdec_output_ >> 14) & 2) | (pdec_output_ & 1)]);
 }
 
 static
@@ -1453,9 +2523,10 @@ clamp_i8(const int8_t x_,
 
 static
 uint32_t
-PPROC(uint32_t pixel_,
-      uint32_t fpix_,
-      uint32_t amv_)
+PPROC(madam_ctx_t *ctx_,
+      uint32_t     pixel_,
+      uint32_t     fpix_,
+      uint32_t     amv_)
 {
   AVS_t AV;
   PXC_t pixc;
@@ -1484,11 +2555,11 @@ PPROC(uint32_t pixel_,
     This is a duty of the PROJECTOR, but we'll do it here because its
     easier.
   */
-  pixel_ = ((pixel_ | pproj.pmodeORmask) & pproj.pmodeANDmask);
+  pixel_ = ((pixel_ | ctx_->pproj.pmodeORmask) & ctx_->pproj.pmodeANDmask);
 
-  pixc.raw = (PIXC & 0xFFFF);
+  pixc.raw = (ctx_->PIXC & 0xFFFF);
   if(pixel_ & 0x8000)
-    pixc.raw = (PIXC >> 16);
+    pixc.raw = (ctx_->PIXC >> 16);
 
   /*
     now let's select the sources
@@ -1498,7 +2569,7 @@ PPROC(uint32_t pixel_,
     pixc.raw = 0;
   */
 
-  if(CCBFLAGS & CCB_USEAV)
+  if(ctx_->CCBFLAGS & CCB_USEAV)
     {
       AV.raw = pixc.meaning.av;
     }
@@ -1581,8 +2652,8 @@ PPROC(uint32_t pixel_,
   */
 
   /* AOP/BOP calculation */
-  AOP.raw     = (color1.raw & PXOR1);
-  color1.raw &= PXOR2;
+  AOP.raw     = (color1.raw & ctx_->PXOR1);
+  color1.raw &= ctx_->PXOR2;
 
   if(AV.avsignal.NEG)
     BOP.raw = (color2.raw ^ 0x00FFFFFF);
@@ -1613,7 +2684,7 @@ PPROC(uint32_t pixel_,
   out.r16b.b = color2.B;
 
   /* TODO: Is this something the PROJECTOR should do? */
-  if(!(CCBFLAGS & CCB_NOBLK) && (out.raw == 0))
+  if(!(ctx_->CCBFLAGS & CCB_NOBLK) && (out.raw == 0))
     out.raw = (1 << 10);
 
   /*
@@ -1631,33 +2702,354 @@ PPROC(uint32_t pixel_,
   return out.raw;
 }
 
+/*
+  Pixel processors
+
+  Take the decoder output, the frame buffer pixel and the AMV and
+  return the projected pixel. pproc_copy() covers the PIXC setting
+  nearly every cel uses, 0x1F00 (PDC * 8 / 8 + 0), for which the
+  processor passes the decoder's RGB through unchanged whatever
+  PXOR and USEAV are.
+*/
+static
+uint32_t
+pproc_generic(madam_ctx_t    *ctx_,
+              const uint32_t  pdec_output_,
+              const uint32_t  fpix_,
+              const uint32_t  amv_)
+{
+  return PPROJ_OUTPUT(ctx_,pdec_output_,PPROC(ctx_,pdec_output_,fpix_,amv_));
+}
+
+static
+uint32_t
+pproc_copy(madam_ctx_t    *ctx_,
+           const uint32_t  pdec_output_,
+           const uint32_t  fpix_,
+           const uint32_t  amv_)
+{
+  uint32_t out;
+
+  out = (pdec_output_ & 0x7FFF);
+  if(out == 0)
+    out = ctx_->pproc.blank;
+
+  return PPROJ_OUTPUT(ctx_,pdec_output_,out);
+}
+
+#define PIXC_COPY 0x1F00
+
+/*
+  A PIXC half takes the frame buffer pixel as the primary source with
+  1S set or as the secondary one with 2S = 2, nothing else reads it.
+*/
+static
+INLINE
+bool_t
+madam_pixc_reads_frame(const uint32_t pixc_)
+{
+  return ((pixc_ & 0x8000) || ((pixc_ & 0x00C0) == 0x0080));
+}
+
+/*
+  Select the decoder and processor and resolve the projector for the
+  current CCB so nothing is branched on per pixel which is fixed for
+  the whole cel.
+*/
+static
+void
+madam_pixel_pipeline_select(madam_ctx_t *ctx_)
+{
+  uint32_t i;
+  uint32_t vh;
+  uint32_t pixc_lo;
+  uint32_t pixc_hi;
+
+  switch(ctx_->PRE0 & PRE0_BPP_MASK)
+    {
+    default:
+      ctx_->pdec.decode = pdec_plut_coded;
+      break;
+    case PRE0_BPP_6:
+      ctx_->pdec.decode = pdec_6bpp;
+      break;
+    case PRE0_BPP_8:
+      ctx_->pdec.decode = ((ctx_->PRE0 & PRE0_LINEAR) ? pdec_8bpp_linear : pdec_8bpp_coded);
+      break;
+    case PRE0_BPP_16:
+    case 7:
+      ctx_->pdec.decode = ((ctx_->PRE0 & PRE0_LINEAR) ? pdec_16bpp_linear : pdec_16bpp_coded);
+      break;
+    }
+
+  /* PMODE forces bit 15 and with it the half of PIXC used */
+  pixc_lo = ((ctx_->pproj.pmode == PMODE_ONE)  ? PIXC_COPY : (ctx_->PIXC & 0xFFFF));
+  pixc_hi = ((ctx_->pproj.pmode == PMODE_ZERO) ? PIXC_COPY : (ctx_->PIXC >> 16));
+  if((pixc_lo == PIXC_COPY) && (pixc_hi == PIXC_COPY))
+    ctx_->pproc.process = pproc_copy;
+  else
+    ctx_->pproc.process = pproc_generic;
+  ctx_->pproc.blank  = ((ctx_->CCBFLAGS & CCB_NOBLK) ? 0 : (1 << 10));
+  ctx_->pproc.fbread = (madam_pixc_reads_frame(pixc_lo) ||
+                        madam_pixc_reads_frame(pixc_hi));
+
+  for(i = 0; i < 4; i++)
+    {
+      /*
+        CCB_PLUTPOS flag
+        Determine projector's originating source of VH values.
+      */
+      if(ctx_->CCBFLAGS & CCB_PLUTPOS) /* Use pixel decoder output. */
+        vh = (((i & 2) << 14) | (i & 1));
+      else /* Use VH values determined from the CEL's origin. */
+        vh = ctx_->CEL_ORIGIN_VH_VALUE;
+
+      /*
+        SWAPHV flag
+        Swap the H and V values now if requested.
+        TODO: I have read that PRE1 is only set for unpacked CELs.
+        So... should this be ignored if using packed CELs? I don't
+        know.
+      */
+      if((CCBCTL0 & SWAPHV) && !(ctx_->PRE1 & PRE1_NOSWAP))
+        vh = ((vh >> 15) | ((vh & 1) << 15));
+
+      /* Substitute the V value explicitly if requested. */
+      switch(CCBCTL0 & B15POS_MASK)
+        {
+        case B15POS_0:
+          vh &= ~0x8000;
+          break;
+        case B15POS_1:
+          vh |= 0x8000;
+          break;
+        }
+
+      /* Substitute the H value explicitly if requested. */
+      switch(CCBCTL0 & B0POS_MASK)
+        {
+        case B0POS_PPMP:
+        case B0POS_0:
+          vh &= ~0x1;
+          break;
+        case B0POS_1:
+          vh |= 0x1;
+          break;
+        }
+
+      ctx_->pproj.VH[i] = vh;
+    }
+
+  /* Use LSB from pixel processor output. */
+  ctx_->pproj.pprocMask = (((CCBCTL0 & B0POS_MASK) == B0POS_PPMP) ? 0x7FFF : 0x7FFE);
+}
 
 static
 INLINE
 void
-process_pixel(int32_t x_,
-              int32_t y_,
-              uint32_t curpix_,
-              uint32_t lawv_)
+process_pixel(madam_ctx_t *ctx_,
+              int32_t      x_,
+              int32_t      y_,
+              uint32_t     curpix_,
+              uint32_t     lawv_)
 {
   int32_t p;
   int32_t fp;
 
-  fp = mread16(REGCTL2 + XY2OFF(x_,y_,MADAM.rmod));
-  p  = PPROC(curpix_,fp,lawv_);
-  p  = PPROJ_OUTPUT(curpix_,p,fp);
+  if(!madam_band_test(ctx_,y_))
+    return;
+
+  MADAM_STAT_COUNT(ctx_,pixels,1);
+
+  fp = (ctx_->pproc.fbread ? mread16(REGCTL2 + XY2OFF(x_,y_,MADAM.rmod)) : 0);
+  p  = ctx_->pproc.process(ctx_,curpix_,fp,lawv_);
   mwrite16(REGCTL3 + XY2OFF(x_,y_,MADAM.wmod),p);
 }
 
+/*
+  Row blitter
+
+  Cels drawn 1:1 (line map with HDX = 1.0 and HDY = 0) through
+  pproc_copy() don't depend on the frame buffer so a whole run of
+  decoded pixels can be processed and written at once. Pixels land
+  on every other halfword as the two lines of a pair are interleaved
+  in VRAM. Writes are the same mwrite16() would make, transparent
+  pixels are left alone.
+*/
+#define MADAM_ROW_MAX 2048
+
+static
+void
+madam_row_copy_c(madam_ctx_t    *ctx_,
+                 const int32_t   x_,
+                 const int32_t   y_,
+                 const uint16_t *pix_,
+                 const int32_t   n_)
+{
+  int32_t i;
+
+  for(i = 0; i < n_; i++)
+    {
+      if(((pix_[i] & 0x7FFF) == 0) && ctx_->pdec.tmask)
+        continue;
+
+      mwrite16(REGCTL3 + XY2OFF(x_ + i,y_,MADAM.wmod),pproc_copy(ctx_,pix_[i],0,0));
+    }
+}
+
+#if defined(__SSE2__)
+#include "opera_madam_sse2.ic"
+#elif defined(OPERA_NEON) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include "opera_madam_neon.ic"
+#else
+static
+void
+madam_row_copy(madam_ctx_t    *ctx_,
+               const int32_t   x_,
+               const int32_t   y_,
+               const uint16_t *pix_,
+               const int32_t   n_)
+{
+  madam_row_copy_c(ctx_,x_,y_,pix_,n_);
+}
+#endif
+
+/*
+  True when the cel is drawn 1:1 without the frame buffer so rows can
+  go through madam_row_copy().
+*/
+static
+INLINE
+bool_t
+madam_row_copy_enabled(madam_ctx_t *ctx_)
+{
+  return ((ctx_->HDX1616 == (1 << 16)) &&
+          (ctx_->HDY1616 == 0)           &&
+          !(REGCTL3 & 1)                 &&
+          (ctx_->pproc.process == pproc_copy));
+}
+
+/*
+  The row source must not be overwritten by the row itself or
+  decoding it up front would differ from drawing it pixel by pixel.
+*/
+static
+bool_t
+madam_row_overlaps(const uint32_t src_,
+                   const uint32_t len_,
+                   const int32_t  y_)
+{
+  int      i;
+  uint32_t dst;
+  uint32_t len;
+
+  dst = (REGCTL3 + XY2OFF(0,y_,MADAM.wmod));
+  len = ((MADAM.clipx + 1) << 2);
+
+  for(i = 0; i < (HIRESMODE ? 4 : 1); i++)
+    {
+      if((src_ < (dst + len)) && (dst < (src_ + len_)))
+        return TRUE;
+      dst += (1024 * 1024);
+    }
+
+  return FALSE;
+}
+
 uint32_t*
 opera_madam_registers(void)
 {
   return MADAM.mregs;
 }
 
+/*
+  Packed row readers. A cel found in the decoded cel cache has its
+  runs and pixels taken from the entry, the bit stream is read
+  otherwise.
+*/
+static
+INLINE
+void
+packed_row_begin(madam_ctx_t   *ctx_,
+                 const int32_t  row_)
+{
+  if(ctx_->pdec.cache == NULL)
+    return;
+
+  ctx_->prun = &ctx_->pdec.cache->runs[ctx_->pdec.cache->rowrun[row_] * 2];
+  ctx_->ppix = &ctx_->pdec.cache->pixels[ctx_->pdec.cache->rowpix[row_]];
+}
+
+static
+INLINE
+uint32_t
+packed_type_read(madam_ctx_t    *ctx_,
+                 const uint32_t  start_,
+                 const uint32_t  lastaddr_)
+{
+  uint32_t rv;
+
+  if(ctx_->pdec.cache != NULL)
+    return ctx_->prun[0];
+
+  rv = BitReaderBig_Read(&ctx_->bitoper,2);
+  if((BitReaderBig_Point(&ctx_->bitoper) + start_) >= lastaddr_)
+    rv = 0;
+
+  return rv;
+}
+
+static
+INLINE
+int32_t
+packed_count_read(madam_ctx_t *ctx_)
+{
+  int32_t rv;
+
+  if(ctx_->pdec.cache != NULL)
+    {
+      rv = ctx_->prun[1];
+      ctx_->prun += 2;
+      return rv;
+    }
+
+  return (BitReaderBig_Read(&ctx_->bitoper,6) + 1);
+}
+
+static
+INLINE
+uint16_t
+packed_pixel_read(madam_ctx_t *ctx_,
+                  uint16_t    *amv_)
+{
+  uint32_t v;
+
+  if(ctx_->pdec.cache == NULL)
+    return ctx_->pdec.decode(ctx_,BitReaderBig_Read(&ctx_->bitoper,ctx_->bpp),amv_);
+
+  v     = *ctx_->ppix++;
+  *amv_ = (v >> 16);
+
+  pdec_texel(ctx_,v);
+
+  return v;
+}
+
+static
+INLINE
+void
+packed_pixels_skip(madam_ctx_t   *ctx_,
+                   const int32_t  count_)
+{
+  if(ctx_->pdec.cache != NULL)
+    ctx_->ppix += count_;
+  else
+    BitReaderBig_Skip(&ctx_->bitoper,ctx_->bpp * count_);
+}
+
 static
 void
-DrawPackedCel_New(void)
+DrawPackedCel_New(madam_ctx_t *ctx_)
 {
   int row;
   uint16_t CURPIX;
@@ -1673,86 +3065,108 @@ DrawPackedCel_New(void)
   int32_t hdx;
   int32_t hdy;
 
-  uint32_t start = PDATA;
+  int32_t col;
+  int32_t cnt;
+  int32_t j0;
+  int32_t j1;
+
+  uint32_t start = ctx_->SRCDATA;
+  uint16_t rowpix[MADAM_ROW_MAX];
+  struct madam_cull_s cull;
 
-  nrows = ((PRE0 & PRE0_VCNT_MASK) >> PRE0_VCNT_SHIFT);
+  ctx_->nrows = ((ctx_->PRE0 & PRE0_VCNT_MASK) >> PRE0_VCNT_SHIFT);
 
-  bpp = BPP[PRE0 & PRE0_BPP_MASK];
+  ctx_->bpp = BPP[ctx_->PRE0 & PRE0_BPP_MASK];
 
-  offsetl = ((bpp < 8) ? 1 : 2);
+  ctx_->offsetl = ((ctx_->bpp < 8) ? 1 : 2);
 
-  pixcount = 0;
+  ctx_->pixcount = 0;
 
-  SPRHI = nrows + 1;
+  ctx_->SPRHI = ctx_->nrows + 1;
 
-  if(TestInitVisual(1))
-    return;
+  if(TestInitVisual(ctx_,1))
+    {
+      ctx_->stats.culled = 1;
+      return;
+    }
 
-  xvert = XPOS1616;
-  yvert = YPOS1616;
+  xvert = ctx_->XPOS1616;
+  yvert = ctx_->YPOS1616;
 
-  if(TEXEL_FUN_NUMBER == 0)
+  if(ctx_->TEXEL_FUN_NUMBER == 0)
     {
-      for(row = 0; row < TEXTURE_HI_LIM; row++)
+      bool_t celcopy;
+
+      celcopy = madam_row_copy_enabled(ctx_);
+
+      for(row = 0; row < ctx_->TEXTURE_HI_LIM; row++)
         {
-          int wcnt;
-          int scipw;
+          int    wcnt;
+          int    scipw;
+          bool_t rowcopy;
 
-          BitReaderBig_AttachBuffer(&bitoper,start);
-          offset = BitReaderBig_Read(&bitoper,(offsetl << 3));
+          BitReaderBig_AttachBuffer(&ctx_->bitoper,start);
+          ctx_->offset = BitReaderBig_Read(&ctx_->bitoper,(ctx_->offsetl << 3));
+          packed_row_begin(ctx_,row);
 
-          lastaddr  = (start + ((offset + 2) << 2));
-          eor       = 0;
+          lastaddr  = (start + ((ctx_->offset + 2) << 2));
+          ctx_->eor = 0;
           xcur      = xvert;
           ycur      = yvert;
-          xvert    += VDX1616;
-          yvert    += VDY1616;
+          xvert    += ctx_->VDX1616;
+          yvert    += ctx_->VDY1616;
+
+          if(ctx_->TEXTURE_HI_START)
+            {
+              ctx_->TEXTURE_HI_START--;
+              start = lastaddr;
+              continue;
+            }
 
-          if(TEXTURE_HI_START)
+          if(madam_band_skip_line_row(ctx_,ycur,(row == (ctx_->TEXTURE_HI_LIM - 1))))
             {
-              TEXTURE_HI_START--;
               start = lastaddr;
               continue;
             }
 
-          scipw = TEXTURE_WI_START;
-          wcnt  = scipw;
+          scipw   = ctx_->TEXTURE_WI_START;
+          wcnt    = scipw;
+          rowcopy = (celcopy &&
+                     madam_band_test(ctx_,ycur >> 16) &&
+                     !madam_row_overlaps(start,(lastaddr - start),ycur >> 16));
 
           /* while not end of row */
-          while(!eor)
+          while(!ctx_->eor)
             {
-              type = BitReaderBig_Read(&bitoper,2);
-              if((int32_t)(bitoper.point + start) >= (lastaddr))
-                type = 0;
-
-              pixcount = BitReaderBig_Read(&bitoper,6) + 1;
+              ctx_->type     = packed_type_read(ctx_,start,lastaddr);
+              ctx_->pixcount = packed_count_read(ctx_);
 
               if(scipw)
                 {
-                  if(type == 0)
+                  if(ctx_->type == 0)
                     break;
-                  if(scipw >= (int32_t)(pixcount))
+                  if(scipw >= (int32_t)(ctx_->pixcount))
                     {
-                      scipw -= (pixcount);
-                      if(HDX1616)
-                        xcur += (HDX1616 * pixcount);
-                      if(HDY1616)
-                        ycur += (HDY1616 * pixcount);
-                      if(type == 1)
-                        BitReaderBig_Skip(&bitoper,bpp*pixcount);
-                      else if(type == 3)
-                        BitReaderBig_Skip(&bitoper,bpp);
+                      scipw -= (ctx_->pixcount);
+                      if(ctx_->HDX1616)
+                        xcur += (ctx_->HDX1616 * ctx_->pixcount);
+                      if(ctx_->HDY1616)
+                        ycur += (ctx_->HDY1616 * ctx_->pixcount);
+                      if(ctx_->type == 1)
+                        packed_pixels_skip(ctx_,ctx_->pixcount);
+                      else if(ctx_->type == 3)
+                        packed_pixels_skip(ctx_,1);
                       continue;
                     }
                   else
                     {
-                      if(HDX1616)
-                        xcur += (HDX1616 * scipw);
-                      if(HDY1616)
-                        ycur += (HDY1616 * scipw);
-                      pixcount -= scipw;
-                      if(type == 1)
-                        BitReaderBig_Skip(&bitoper,bpp*scipw);
+                      if(ctx_->HDX1616)
+                        xcur += (ctx_->HDX1616 * scipw);
+                      if(ctx_->HDY1616)
+                        ycur += (ctx_->HDY1616 * scipw);
+                      ctx_->pixcount -= scipw;
+                      if(ctx_->type == 1)
+                        packed_pixels_skip(ctx_,scipw);
                       scipw = 0;
                     }
                 }
@@ -1761,142 +3175,207 @@ DrawPackedCel_New(void)
                 if(wcnt >= TEXTURE_WI_LIM)
                 break;
               */
-              wcnt += pixcount;
-              if(wcnt > TEXTURE_WI_LIM)
+              wcnt += ctx_->pixcount;
+              if(wcnt > ctx_->TEXTURE_WI_LIM)
                 {
-                  pixcount -= (wcnt - TEXTURE_WI_LIM);
+                  ctx_->pixcount -= (wcnt - ctx_->TEXTURE_WI_LIM);
                   /*
                     if(pixcount >> 31)
                     break;
                   */
                 }
 
-              switch(type)
+              switch(ctx_->type)
                 {
                 case 0: /* end of row */
-                  eor = 1;
+                  ctx_->eor = 1;
                   break;
                 case 1: /* PACK_LITERAL */
                   {
                     int pix;
-                    for(pix = 0; pix < pixcount; pix++)
+
+                    if(rowcopy && (ctx_->pixcount > 0))
+                      {
+                        uint64_t transparent;
+
+                        transparent = ctx_->stats.transparent;
+                        for(pix = 0; pix < ctx_->pixcount; pix++)
+                          rowpix[pix] = packed_pixel_read(ctx_,&LAMV);
+
+                        madam_row_copy(ctx_,xcur >> 16,ycur >> 16,rowpix,ctx_->pixcount);
+                        MADAM_STAT_COUNT(ctx_,pixels,(ctx_->pixcount - (ctx_->stats.transparent - transparent)));
+
+                        xcur += (ctx_->HDX1616 * ctx_->pixcount);
+                        break;
+                      }
+
+                    for(pix = 0; pix < ctx_->pixcount; pix++)
                       {
-                        CURPIX = PDEC(BitReaderBig_Read(&bitoper,bpp),&LAMV);
-                        if(!pproj.Transparent)
-                          process_pixel(xcur >> 16,ycur >> 16,CURPIX,LAMV);
+                        CURPIX = packed_pixel_read(ctx_,&LAMV);
+                        if(!ctx_->pproj.Transparent)
+                          process_pixel(ctx_,xcur >> 16,ycur >> 16,CURPIX,LAMV);
 
-                        xcur += HDX1616;
-                        ycur += HDY1616;
+                        xcur += ctx_->HDX1616;
+                        ycur += ctx_->HDY1616;
                       }
                   }
                   break;
                 case 2: /* PACK_TRANSPARENT */
-                  if(HDX1616)
-                    xcur += (HDX1616 * pixcount);
-                  if(HDY1616)
-                    ycur += (HDY1616 * pixcount);
+                  MADAM_STAT_COUNT(ctx_,texels,ctx_->pixcount);
+                  MADAM_STAT_COUNT(ctx_,transparent,ctx_->pixcount);
+                  if(ctx_->HDX1616)
+                    xcur += (ctx_->HDX1616 * ctx_->pixcount);
+                  if(ctx_->HDY1616)
+                    ycur += (ctx_->HDY1616 * ctx_->pixcount);
                   break;
                 case 3: /* PACK_REPEAT */
-                  CURPIX = PDEC(BitReaderBig_Read(&bitoper,bpp),&LAMV);
+                  CURPIX = packed_pixel_read(ctx_,&LAMV);
 
-                  if(!pproj.Transparent)
-                    TexelDraw_Line(CURPIX,LAMV,xcur,ycur,pixcount);
+                  if(rowcopy && (ctx_->pixcount > 0))
+                    {
+                      int pix;
+
+                      for(pix = 0; pix < ctx_->pixcount; pix++)
+                        rowpix[pix] = CURPIX;
+
+                      madam_row_copy(ctx_,xcur >> 16,ycur >> 16,rowpix,ctx_->pixcount);
+                      if(!ctx_->pproj.Transparent)
+                        MADAM_STAT_COUNT(ctx_,pixels,ctx_->pixcount);
+                    }
+                  else if(!ctx_->pproj.Transparent)
+                    {
+                      TexelDraw_Line(ctx_,CURPIX,LAMV,xcur,ycur,ctx_->pixcount);
+                    }
 
-                  if(HDX1616)
-                    xcur += (HDX1616 * pixcount);
-                  if(HDY1616)
-                    ycur += (HDY1616 * pixcount);
+                  if(ctx_->HDX1616)
+                    xcur += (ctx_->HDX1616 * ctx_->pixcount);
+                  if(ctx_->HDY1616)
+                    ycur += (ctx_->HDY1616 * ctx_->pixcount);
                   break;
                 }
 
-              if(wcnt >= TEXTURE_WI_LIM)
+              if(wcnt >= ctx_->TEXTURE_WI_LIM)
                 break;
             }
 
           start = lastaddr;
         }
     }
-  else if(TEXEL_FUN_NUMBER == 1)
+  else if(ctx_->TEXEL_FUN_NUMBER == 1)
     {
       int row;
       int drawHeight;
 
-      drawHeight = VDY1616;
-      if((CCBFLAGS & CCB_MARIA) && (drawHeight > (1 << 16)))
+      drawHeight = ctx_->VDY1616;
+      if((ctx_->CCBFLAGS & CCB_MARIA) && (drawHeight > (1 << 16)))
         drawHeight = (1 << 16);
 
-      for(row = 0; row < SPRHI; row++)
+      for(row = 0; row < ctx_->SPRHI; row++)
         {
-          BitReaderBig_AttachBuffer(&bitoper,start);
-          offset = BitReaderBig_Read(&bitoper,(offsetl << 3));
+          BitReaderBig_AttachBuffer(&ctx_->bitoper,start);
+          ctx_->offset = BitReaderBig_Read(&ctx_->bitoper,(ctx_->offsetl << 3));
+          packed_row_begin(ctx_,row);
 
-          lastaddr = (start + ((offset + 2) << 2));
+          lastaddr = (start + ((ctx_->offset + 2) << 2));
 
-          eor = 0;
+          ctx_->eor = 0;
 
           xcur   = xvert;
           ycur   = yvert;
-          xvert += VDX1616;
-          yvert += VDY1616;
+          xvert += ctx_->VDX1616;
+          yvert += ctx_->VDY1616;
+
+          if(madam_band_skip_scale_row(ctx_,ycur,drawHeight,(row == (ctx_->SPRHI - 1))))
+            {
+              start = lastaddr;
+              continue;
+            }
+
+          j0 = 0;
+          j1 = INT32_MAX;
+          if(madam_cull_scale(ctx_,&cull,xcur,ycur,drawHeight) &&
+             madam_cull_columns(&cull,
+                                madam_packed_row_max(ctx_,lastaddr - start),
+                                (row == (ctx_->SPRHI - 1)),
+                                &j0,&j1))
+            {
+              madam_cull_count(ctx_,1,0);
+              start = lastaddr;
+              continue;
+            }
 
           /* while not end of row */
-          while(!eor)
+          for(col = 0; !ctx_->eor; col += cnt)
             {
               int32_t __pix;
 
-              type = BitReaderBig_Read(&bitoper,2);
-              if((bitoper.point + start) >= lastaddr)
-                type = 0;
+              ctx_->type = packed_type_read(ctx_,start,lastaddr);
+              __pix      = packed_count_read(ctx_);
+              cnt        = __pix;
 
-              __pix = (BitReaderBig_Read(&bitoper,6) + 1);
+              /* whole runs ahead of the visible columns are stepped over */
+              if((ctx_->type != 0) && ((col + __pix) <= j0))
+                {
+                  if(ctx_->type == 1)
+                    packed_pixels_skip(ctx_,__pix);
+                  else if(ctx_->type == 3)
+                    packed_pixels_skip(ctx_,1);
+                  xcur += (ctx_->HDX1616 * __pix);
+                  ycur += (ctx_->HDY1616 * __pix);
+                  madam_cull_count(ctx_,0,__pix);
+                  continue;
+                }
+
+              if(col >= j1)
+                break;
 
-              switch(type)
+              switch(ctx_->type)
                 {
                 case 0: /* end of row */
-                  eor = 1;
+                  ctx_->eor = 1;
                   break;
                 case 1: /* PACK_LITERAL */
                   while(__pix)
                     {
                       __pix--;
-                      CURPIX = PDEC(BitReaderBig_Read(&bitoper,bpp),&LAMV);
+                      CURPIX = packed_pixel_read(ctx_,&LAMV);
 
-                      if(!pproj.Transparent)
+                      if(!ctx_->pproj.Transparent)
                         {
-                          if(TexelDraw_Scale(CURPIX,
+                          if(TexelDraw_Scale(ctx_,CURPIX,
                                              LAMV,
                                              xcur >> 16,
                                              ycur >> 16,
-                                             ((xcur + (HDX1616 + VDX1616)) >> 16),
-                                             ((ycur + (HDY1616 + drawHeight)) >> 16)))
+                                             ((xcur + (ctx_->HDX1616 + ctx_->VDX1616)) >> 16),
+                                             ((ycur + (ctx_->HDY1616 + drawHeight)) >> 16)))
                             break;
                         }
 
-                      xcur += HDX1616;
-                      ycur += HDY1616;
+                      xcur += ctx_->HDX1616;
+                      ycur += ctx_->HDY1616;
                     }
                   break;
                 case 2: /* PACK_TRANSPARENT */
-                  xcur  += (HDX1616 * __pix);
-                  ycur  += (HDY1616 * __pix);
+                  xcur  += (ctx_->HDX1616 * __pix);
+                  ycur  += (ctx_->HDY1616 * __pix);
                   __pix  = 0;
                   break;
                 case 3: /* PACK_REPEAT */
-                  CURPIX = PDEC(BitReaderBig_Read(&bitoper,bpp),&LAMV);
-                  if(!pproj.Transparent)
+                  CURPIX = packed_pixel_read(ctx_,&LAMV);
+                  if(!ctx_->pproj.Transparent)
                     {
-                      if(TexelDraw_Scale(CURPIX,
+                      if(TexelDraw_Scale(ctx_,CURPIX,
                                          LAMV,
                                          xcur >> 16,
                                          ycur >> 16,
-                                         ((xcur + (HDX1616 * __pix) + VDX1616) >> 16),
-                                         ((ycur + (HDY1616 * __pix) + drawHeight) >> 16)))
+                                         ((xcur + (ctx_->HDX1616 * __pix) + ctx_->VDX1616) >> 16),
+                                         ((ycur + (ctx_->HDY1616 * __pix) + drawHeight) >> 16)))
                         break;
 
                     }
 
-                  xcur += (HDX1616 * __pix);
-                  ycur += (HDY1616 * __pix);
+                  xcur += (ctx_->HDX1616 * __pix);
+                  ycur += (ctx_->HDY1616 * __pix);
                   __pix = 0;
                   break;
                 }
@@ -1911,91 +3390,126 @@ DrawPackedCel_New(void)
   else
     {
       int row;
-      for(row = 0; row < SPRHI; row++)
+      for(row = 0; row < ctx_->SPRHI; row++)
         {
-          BitReaderBig_AttachBuffer(&bitoper,start);
-          offset = BitReaderBig_Read(&bitoper,(offsetl << 3));
+          BitReaderBig_AttachBuffer(&ctx_->bitoper,start);
+          ctx_->offset = BitReaderBig_Read(&ctx_->bitoper,(ctx_->offsetl << 3));
+          packed_row_begin(ctx_,row);
 
-          lastaddr = (start + ((offset + 2) << 2));
+          lastaddr = (start + ((ctx_->offset + 2) << 2));
 
-          eor = 0;
+          ctx_->eor = 0;
 
           xcur = xvert;
           ycur = yvert;
-          hdx  = HDX1616;
-          hdy  = HDY1616;
+          hdx  = ctx_->HDX1616;
+          hdy  = ctx_->HDY1616;
 
-          xvert   += VDX1616;
-          yvert   += VDY1616;
-          HDX1616 += HDDX1616;
-          HDY1616 += HDDY1616;
+          xvert         += ctx_->VDX1616;
+          yvert         += ctx_->VDY1616;
+          ctx_->HDX1616 += ctx_->HDDX1616;
+          ctx_->HDY1616 += ctx_->HDDY1616;
 
           xdown = xvert;
           ydown = yvert;
 
+          if(madam_band_skip_row(ctx_,INT32_MIN,INT32_MAX,(row == (ctx_->SPRHI - 1))) ||
+             madam_band_passed(ctx_,ycur,hdy,ydown))
+            {
+              start = lastaddr;
+              continue;
+            }
+
+          madam_cull_quad(ctx_,&cull,xcur,ycur,hdx,hdy,xdown,ydown);
+          if(madam_cull_columns(&cull,
+                                madam_packed_row_max(ctx_,lastaddr - start),
+                                (row == (ctx_->SPRHI - 1)),
+                                &j0,&j1))
+            {
+              madam_cull_count(ctx_,1,0);
+              start = lastaddr;
+              continue;
+            }
+
           /* while not end of row */
-          while(!eor)
+          for(col = 0; !ctx_->eor; col += cnt)
             {
               int32_t __pix;
 
-              type = BitReaderBig_Read(&bitoper,2);
-              if((bitoper.point + start) >= lastaddr)
-                type = 0;
+              ctx_->type = packed_type_read(ctx_,start,lastaddr);
+              __pix      = packed_count_read(ctx_);
+              cnt        = __pix;
+
+              /* whole runs ahead of the visible columns are stepped over */
+              if((ctx_->type != 0) && ((col + __pix) <= j0))
+                {
+                  if(ctx_->type == 1)
+                    packed_pixels_skip(ctx_,__pix);
+                  else if(ctx_->type == 3)
+                    packed_pixels_skip(ctx_,1);
+                  xcur  += (hdx * __pix);
+                  ycur  += (hdy * __pix);
+                  xdown += (ctx_->HDX1616 * __pix);
+                  ydown += (ctx_->HDY1616 * __pix);
+                  madam_cull_count(ctx_,0,__pix);
+                  continue;
+                }
 
-              __pix = (BitReaderBig_Read(&bitoper,6) + 1);
+              if(col >= j1)
+                break;
 
-              switch(type)
+              switch(ctx_->type)
                 {
                 case 0: /* end of row */
-                  eor = 1;
+                  ctx_->eor = 1;
                   break;
                 case 1: /* PACK_LITERAL */
                   while(__pix)
                     {
-                      CURPIX = PDEC(BitReaderBig_Read(&bitoper,bpp),&LAMV);
+                      CURPIX = packed_pixel_read(ctx_,&LAMV);
                       __pix--;
 
-                      if(!pproj.Transparent)
+                      if(!ctx_->pproj.Transparent)
                         {
-                          if(TexelDraw_Arbitrary(CURPIX,LAMV,xcur,ycur,xcur+hdx,ycur+hdy,xdown+HDX1616,ydown+HDY1616,xdown,ydown))
+                          if(TexelDraw_Arbitrary(ctx_,CURPIX,LAMV,xcur,ycur,xcur+hdx,ycur+hdy,xdown+ctx_->HDX1616,ydown+ctx_->HDY1616,xdown,ydown))
                             break;
                         }
 
                       xcur  += hdx;
                       ycur  += hdy;
-                      xdown += HDX1616;
-                      ydown += HDY1616;
+                      xdown += ctx_->HDX1616;
+                      ydown += ctx_->HDY1616;
                     }
                   break;
                 case 2: /* PACK_TRANSPARENT */
                   xcur  += (hdx * __pix);
                   ycur  += (hdy * __pix);
-                  xdown += (HDX1616 * __pix);
-                  ydown += (HDY1616 * __pix);
+                  xdown += (ctx_->HDX1616 * __pix);
+                  ydown += (ctx_->HDY1616 * __pix);
                   __pix  = 0;
                   break;
                 case 3: /* PACK_REPEAT */
-                  CURPIX = PDEC(BitReaderBig_Read(&bitoper,bpp),&LAMV);
+                  CURPIX = packed_pixel_read(ctx_,&LAMV);
 
-                  if(!pproj.Transparent)
+                  if(!ctx_->pproj.Transparent)
                     {
                       while(__pix)
                         {
                           __pix--;
-                          if(TexelDraw_Arbitrary(CURPIX,LAMV,xcur,ycur,xcur+hdx,ycur+hdy,xdown+HDX1616,ydown+HDY1616,xdown,ydown))
+                          if(TexelDraw_Arbitrary(ctx_,CURPIX,LAMV,xcur,ycur,xcur+hdx,ycur+hdy,xdown+ctx_->HDX1616,ydown+ctx_->HDY1616,xdown,ydown))
                             break;
                           xcur  += hdx;
                           ycur  += hdy;
-                          xdown += HDX1616;
-                          ydown += HDY1616;
+                          xdown += ctx_->HDX1616;
+                          ydown += ctx_->HDY1616;
                         }
                     }
                   else
                     {
                       xcur  += (hdx * __pix);
                       ycur  += (hdy * __pix);
-                      xdown += (HDX1616 * __pix);
-                      ydown += (HDY1616 * __pix);
+                      xdown += (ctx_->HDX1616 * __pix);
+                      ydown += (ctx_->HDY1616 * __pix);
                       __pix  = 0;
                     }
                   break;
@@ -2003,23 +3517,26 @@ DrawPackedCel_New(void)
 
               if(__pix)
                 break;
+
+              if(madam_band_passed(ctx_,ycur,hdy,ydown))
+                break;
             }
 
           start = lastaddr;
         }
     }
 
-  SPRWI++;
+  ctx_->SPRWI++;
 
   if(FIXMODE & FIX_BIT_GRAPHICS_STEP_Y)
-    YPOS1616 = ycur;
+    ctx_->YPOS1616 = ycur;
   else
-    XPOS1616 = xcur;
+    ctx_->XPOS1616 = xcur;
 }
 
 static
 void
-DrawLiteralCel_New(void)
+DrawLiteralCel_New(madam_ctx_t *ctx_)
 {
   int32_t xcur;
   int32_t ycur;
@@ -2029,65 +3546,102 @@ DrawLiteralCel_New(void)
   int32_t ydown;
   int32_t hdx;
   int32_t hdy;
+  int32_t j0;
+  int32_t j1;
   uint16_t CURPIX;
   uint16_t LAMV;
+  uint16_t rowpix[MADAM_ROW_MAX];
+  struct madam_cull_s cull;
 
-  bpp      = BPP[PRE0 & PRE0_BPP_MASK];
-  offsetl  = ((bpp < 8) ? 1 : 2);
-  pixcount = 0;
-  offset   = ((offsetl == 1) ?
-              ((PRE1 & PRE1_WOFFSET8_MASK) >> PRE1_WOFFSET8_SHIFT):
-              ((PRE1 & PRE1_WOFFSET10_MASK) >> PRE1_WOFFSET10_SHIFT));
+  ctx_->bpp      = BPP[ctx_->PRE0 & PRE0_BPP_MASK];
+  ctx_->offsetl  = ((ctx_->bpp < 8) ? 1 : 2);
+  ctx_->pixcount = 0;
+  ctx_->offset   = ((ctx_->offsetl == 1) ?
+                    ((ctx_->PRE1 & PRE1_WOFFSET8_MASK) >> PRE1_WOFFSET8_SHIFT):
+                    ((ctx_->PRE1 & PRE1_WOFFSET10_MASK) >> PRE1_WOFFSET10_SHIFT));
 
-  SPRWI = (1 + (PRE1 & PRE1_TLHPCNT_MASK));
-  SPRHI = (1 + ((PRE0 & PRE0_VCNT_MASK) >> PRE0_VCNT_SHIFT));
+  ctx_->SPRWI = (1 + (ctx_->PRE1 & PRE1_TLHPCNT_MASK));
+  ctx_->SPRHI = (1 + ((ctx_->PRE0 & PRE0_VCNT_MASK) >> PRE0_VCNT_SHIFT));
 
-  if(TestInitVisual(0))
-    return;
+  if(TestInitVisual(ctx_,0))
+    {
+      ctx_->stats.culled = 1;
+      return;
+    }
 
-  xvert = XPOS1616;
-  yvert = YPOS1616;
+  xvert = ctx_->XPOS1616;
+  yvert = ctx_->YPOS1616;
 
-  switch(TEXEL_FUN_NUMBER)
+  switch(ctx_->TEXEL_FUN_NUMBER)
     {
     case 0:
       {
         uint32_t i;
+        bool_t   rowcopy;
 
-        SPRWI -= ((PRE0 >> 24) & 0xF);
-        xvert += (TEXTURE_HI_START * VDX1616);
-        yvert += (TEXTURE_HI_START * VDY1616);
-        PDATA += (((offset + 2) << 2) * TEXTURE_HI_START);
+        rowcopy = madam_row_copy_enabled(ctx_);
 
-        if(SPRWI > TEXTURE_WI_LIM)
-          SPRWI = TEXTURE_WI_LIM;
+        ctx_->SPRWI -= ((ctx_->PRE0 >> 24) & 0xF);
+        xvert += (ctx_->TEXTURE_HI_START * ctx_->VDX1616);
+        yvert += (ctx_->TEXTURE_HI_START * ctx_->VDY1616);
+        ctx_->SRCDATA += (((ctx_->offset + 2) << 2) * ctx_->TEXTURE_HI_START);
 
-        for(i = TEXTURE_HI_START; i < TEXTURE_HI_LIM; i++)
+        if(ctx_->SPRWI > ctx_->TEXTURE_WI_LIM)
+          ctx_->SPRWI = ctx_->TEXTURE_WI_LIM;
+
+        for(i = ctx_->TEXTURE_HI_START; i < ctx_->TEXTURE_HI_LIM; i++)
           {
             uint32_t j;
 
-            BitReaderBig_AttachBuffer(&bitoper,PDATA);
-            xcur = (xvert + TEXTURE_WI_START * HDX1616);
-            ycur = (yvert + TEXTURE_WI_START * HDY1616);
-            BitReaderBig_Skip(&bitoper,(bpp * (((PRE0 >> 24) & 0xF))));
-            if(TEXTURE_WI_START)
-              BitReaderBig_Skip(&bitoper,(bpp * TEXTURE_WI_START));
+            BitReaderBig_AttachBuffer(&ctx_->bitoper,ctx_->SRCDATA);
+            xcur = (xvert + ctx_->TEXTURE_WI_START * ctx_->HDX1616);
+            ycur = (yvert + ctx_->TEXTURE_WI_START * ctx_->HDY1616);
+            BitReaderBig_Skip(&ctx_->bitoper,(ctx_->bpp * (((ctx_->PRE0 >> 24) & 0xF))));
+            if(ctx_->TEXTURE_WI_START)
+              BitReaderBig_Skip(&ctx_->bitoper,(ctx_->bpp * ctx_->TEXTURE_WI_START));
+
+            xvert += ctx_->VDX1616;
+            yvert += ctx_->VDY1616;
 
-            xvert += VDX1616;
-            yvert += VDY1616;
+            if(madam_band_skip_line_row(ctx_,ycur,(i == (ctx_->TEXTURE_HI_LIM - 1))))
+              {
+                ctx_->SRCDATA += ((ctx_->offset + 2) << 2);
+                continue;
+              }
+
+            if(rowcopy &&
+               (ctx_->SPRWI > ctx_->TEXTURE_WI_START) &&
+               madam_band_test(ctx_,ycur >> 16) &&
+               !madam_row_overlaps(ctx_->SRCDATA,((ctx_->offset + 2) << 2),ycur >> 16))
+              {
+                int32_t  n;
+                uint64_t transparent;
 
-            for(j = TEXTURE_WI_START; j < SPRWI; j++)
+                n = (ctx_->SPRWI - ctx_->TEXTURE_WI_START);
+                transparent = ctx_->stats.transparent;
+                for(j = 0; j < n; j++)
+                  rowpix[j] = ctx_->pdec.decode(ctx_,BitReaderBig_Read(&ctx_->bitoper,ctx_->bpp),&LAMV);
+
+                madam_row_copy(ctx_,xcur >> 16,ycur >> 16,rowpix,n);
+                MADAM_STAT_COUNT(ctx_,pixels,(n - (ctx_->stats.transparent - transparent)));
+
+                xcur += (ctx_->HDX1616 * n);
+              }
+            else
               {
-                CURPIX = PDEC(BitReaderBig_Read(&bitoper,bpp),&LAMV);
+                for(j = ctx_->TEXTURE_WI_START; j < ctx_->SPRWI; j++)
+                  {
+                    CURPIX = ctx_->pdec.decode(ctx_,BitReaderBig_Read(&ctx_->bitoper,ctx_->bpp),&LAMV);
 
-                if(!pproj.Transparent)
-                  process_pixel(xcur >> 16,ycur >> 16,CURPIX,LAMV);
+                    if(!ctx_->pproj.Transparent)
+                      process_pixel(ctx_,xcur >> 16,ycur >> 16,CURPIX,LAMV);
 
-                xcur += HDX1616;
-                ycur += HDY1616;
+                    xcur += ctx_->HDX1616;
+                    ycur += ctx_->HDY1616;
+                  }
               }
 
-            PDATA += ((offset+2) << 2);
+            ctx_->SRCDATA += ((ctx_->offset+2) << 2);
           }
       }
       break;
@@ -2097,41 +3651,61 @@ DrawLiteralCel_New(void)
         uint32_t i;
         uint32_t j;
 
-        SPRWI -= ((PRE0 >> 24) & 0xF);
+        ctx_->SPRWI -= ((ctx_->PRE0 >> 24) & 0xF);
 
-        drawHeight = VDY1616;
-        if((CCBFLAGS & CCB_MARIA) && (drawHeight > (1 << 16)))
+        drawHeight = ctx_->VDY1616;
+        if((ctx_->CCBFLAGS & CCB_MARIA) && (drawHeight > (1 << 16)))
           drawHeight = (1 << 16);
 
-        for(i = 0; i < SPRHI; i++)
+        for(i = 0; i < ctx_->SPRHI; i++)
           {
-            BitReaderBig_AttachBuffer(&bitoper,PDATA);
+            BitReaderBig_AttachBuffer(&ctx_->bitoper,ctx_->SRCDATA);
             xcur   = xvert;
             ycur   = yvert;
-            xvert += VDX1616;
-            yvert += VDY1616;
-            BitReaderBig_Skip(&bitoper,(bpp * (((PRE0 >> 24) & 0xF))));
+            xvert += ctx_->VDX1616;
+            yvert += ctx_->VDY1616;
+
+            if(madam_band_skip_scale_row(ctx_,ycur,drawHeight,(i == (ctx_->SPRHI - 1))))
+              {
+                ctx_->SRCDATA += ((ctx_->offset + 2) << 2);
+                continue;
+              }
+
+            j0 = 0;
+            j1 = ctx_->SPRWI;
+            if(madam_cull_scale(ctx_,&cull,xcur,ycur,drawHeight) &&
+               madam_cull_columns(&cull,ctx_->SPRWI,(i == (ctx_->SPRHI - 1)),&j0,&j1))
+              {
+                madam_cull_count(ctx_,1,ctx_->SPRWI);
+                ctx_->SRCDATA += ((ctx_->offset + 2) << 2);
+                continue;
+              }
+
+            madam_cull_count(ctx_,0,(ctx_->SPRWI - (j1 - j0)));
+            BitReaderBig_Skip(&ctx_->bitoper,(ctx_->bpp * (((ctx_->PRE0 >> 24) & 0xF) + j0)));
+            xcur += (ctx_->HDX1616 * j0);
+            ycur += (ctx_->HDY1616 * j0);
 
-            for(j = 0; j < SPRWI; j++)
+            for(j = j0; j < j1; j++)
               {
-                CURPIX = PDEC(BitReaderBig_Read(&bitoper,bpp),&LAMV);
+                CURPIX = ctx_->pdec.decode(ctx_,BitReaderBig_Read(&ctx_->bitoper,ctx_->bpp),&LAMV);
 
-                if(!pproj.Transparent)
+                if(!ctx_->pproj.Transparent)
                   {
-                    if(TexelDraw_Scale(CURPIX,
+                    if(TexelDraw_Scale(ctx_,CURPIX,
                                        LAMV,
                                        xcur >> 16,
                                        ycur >> 16,
-                                       ((xcur + HDX1616 + VDX1616) >> 16),
-                                       ((ycur + HDY1616 + drawHeight) >> 16)))
+                                       ((xcur + ctx_->HDX1616 + ctx_->VDX1616) >> 16),
+                                       ((ycur + ctx_->HDY1616 + drawHeight) >> 16)))
                       break;
                   }
 
-                xcur += HDX1616;
-                ycur += HDY1616;
+                xcur += ctx_->HDX1616;
+                ycur += ctx_->HDY1616;
               }
 
-            PDATA += ((offset + 2) << 2);
+            ctx_->SRCDATA += ((ctx_->offset + 2) << 2);
           }
       }
       break;
@@ -2140,57 +3714,78 @@ DrawLiteralCel_New(void)
         uint32_t i;
         uint32_t j;
 
-        SPRWI -= ((PRE0 >> 24) & 0xF);
-        for(i = 0; i < SPRHI; i++)
+        ctx_->SPRWI -= ((ctx_->PRE0 >> 24) & 0xF);
+        for(i = 0; i < ctx_->SPRHI; i++)
           {
-            BitReaderBig_AttachBuffer(&bitoper,PDATA);
+            BitReaderBig_AttachBuffer(&ctx_->bitoper,ctx_->SRCDATA);
 
             xcur = xvert;
             ycur = yvert;
-            hdx  = HDX1616;
-            hdy  = HDY1616;
+            hdx  = ctx_->HDX1616;
+            hdy  = ctx_->HDY1616;
 
-            xvert   += VDX1616;
-            yvert   += VDY1616;
-            HDX1616 += HDDX1616;
-            HDY1616 += HDDY1616;
+            xvert         += ctx_->VDX1616;
+            yvert         += ctx_->VDY1616;
+            ctx_->HDX1616 += ctx_->HDDX1616;
+            ctx_->HDY1616 += ctx_->HDDY1616;
 
-            BitReaderBig_Skip(&bitoper,(bpp * (((PRE0 >> 24) & 0xF))));
+            BitReaderBig_Skip(&ctx_->bitoper,(ctx_->bpp * (((ctx_->PRE0 >> 24) & 0xF))));
 
             xdown = xvert;
             ydown = yvert;
 
-            for(j = 0; j < SPRWI; j++)
+            if(madam_band_skip_quad_row(ctx_,ycur,hdy,ydown,ctx_->SPRWI,(i == (ctx_->SPRHI - 1))))
               {
-                CURPIX = PDEC(BitReaderBig_Read(&bitoper,bpp),&LAMV);
+                ctx_->SRCDATA += ((ctx_->offset + 2) << 2);
+                continue;
+              }
+
+            madam_cull_quad(ctx_,&cull,xcur,ycur,hdx,hdy,xdown,ydown);
+            if(madam_cull_columns(&cull,ctx_->SPRWI,(i == (ctx_->SPRHI - 1)),&j0,&j1))
+              {
+                madam_cull_count(ctx_,1,ctx_->SPRWI);
+                ctx_->SRCDATA += ((ctx_->offset + 2) << 2);
+                continue;
+              }
 
-                if(!pproj.Transparent)
+            madam_cull_count(ctx_,0,(ctx_->SPRWI - (j1 - j0)));
+            BitReaderBig_Skip(&ctx_->bitoper,(ctx_->bpp * j0));
+            xcur  += (hdx * j0);
+            ycur  += (hdy * j0);
+            xdown += (ctx_->HDX1616 * j0);
+            ydown += (ctx_->HDY1616 * j0);
+
+            for(j = j0; j < j1; j++)
+              {
+                CURPIX = ctx_->pdec.decode(ctx_,BitReaderBig_Read(&ctx_->bitoper,ctx_->bpp),&LAMV);
+
+                if(!ctx_->pproj.Transparent)
                   {
-                    if(TexelDraw_Arbitrary(CURPIX, LAMV, xcur, ycur, xcur+hdx, ycur+hdy, xdown+HDX1616, ydown+HDY1616, xdown, ydown))
+                    if(TexelDraw_Arbitrary(ctx_,CURPIX, LAMV, xcur, ycur, xcur+hdx, ycur+hdy, xdown+ctx_->HDX1616, ydown+ctx_->HDY1616, xdown, ydown))
                       break;
                   }
 
                 xcur  += hdx;
                 ycur  += hdy;
-                xdown += HDX1616;
-                ydown += HDY1616;
+                xdown += ctx_->HDX1616;
+                ydown += ctx_->HDY1616;
               }
 
-            PDATA += (((offset + 2) << 2));
+            ctx_->SRCDATA += (((ctx_->offset + 2) << 2));
           }
       }
       break;
     }
 
   if(FIXMODE & FIX_BIT_GRAPHICS_STEP_Y)
-    YPOS1616 = ycur;
+    ctx_->YPOS1616 = ycur;
   else
-    XPOS1616 = xcur;
+    ctx_->XPOS1616 = xcur;
 }
 
 static
 void
-DrawLRCel_New(void)
+DrawLRCel_New(madam_ctx_t *ctx_)
 {
   int32_t i;
   int32_t j;
@@ -2202,67 +3797,78 @@ DrawLRCel_New(void)
   int32_t ydown;
   int32_t hdx;
   int32_t hdy;
+  int32_t j0;
+  int32_t j1;
   uint16_t CURPIX;
   uint16_t LAMV;
+  struct madam_cull_s cull;
 
-  bpp       = BPP[PRE0 & PRE0_BPP_MASK];
-  offsetl   = ((bpp < 8) ? 1 : 2);
-  pixcount  = 0;
-  offset    = ((offsetl == 1) ?
-               ((PRE1 & PRE1_WOFFSET8_MASK)  >> PRE1_WOFFSET8_SHIFT) :
-               ((PRE1 & PRE1_WOFFSET10_MASK) >> PRE1_WOFFSET10_SHIFT));
-  offset   += 2;
+  ctx_->bpp      = BPP[ctx_->PRE0 & PRE0_BPP_MASK];
+  ctx_->offsetl  = ((ctx_->bpp < 8) ? 1 : 2);
+  ctx_->pixcount = 0;
+  ctx_->offset   = ((ctx_->offsetl == 1) ?
+                    ((ctx_->PRE1 & PRE1_WOFFSET8_MASK)  >> PRE1_WOFFSET8_SHIFT) :
+                    ((ctx_->PRE1 & PRE1_WOFFSET10_MASK) >> PRE1_WOFFSET10_SHIFT));
+  ctx_->offset   += 2;
 
-  SPRWI = (1 + (PRE1 & PRE1_TLHPCNT_MASK));
-  SPRHI = ((((PRE0 & PRE0_VCNT_MASK) >> PRE0_VCNT_SHIFT) << 1) + 2); /* doom fix */
+  ctx_->SPRWI = (1 + (ctx_->PRE1 & PRE1_TLHPCNT_MASK));
+  ctx_->SPRHI = ((((ctx_->PRE0 & PRE0_VCNT_MASK) >> PRE0_VCNT_SHIFT) << 1) + 2); /* doom fix */
 
-  if(TestInitVisual(0))
-    return;
+  if(TestInitVisual(ctx_,0))
+    {
+      ctx_->stats.culled = 1;
+      return;
+    }
 
-  xvert = XPOS1616;
-  yvert = YPOS1616;
+  xvert = ctx_->XPOS1616;
+  yvert = ctx_->YPOS1616;
 
-  switch(TEXEL_FUN_NUMBER)
+  switch(ctx_->TEXEL_FUN_NUMBER)
     {
     case 0:
-      xvert += (TEXTURE_HI_START * VDX1616);
-      yvert += (TEXTURE_HI_START * VDY1616);
+      xvert += (ctx_->TEXTURE_HI_START * ctx_->VDX1616);
+      yvert += (ctx_->TEXTURE_HI_START * ctx_->VDY1616);
       /*
         if(SPRHI > TEXTURE_HI_LIM)
         SPRHI = TEXTURE_HI_LIM;
       */
 
-      if(SPRWI > TEXTURE_WI_LIM)
-        SPRWI = TEXTURE_WI_LIM;
+      if(ctx_->SPRWI > ctx_->TEXTURE_WI_LIM)
+        ctx_->SPRWI = ctx_->TEXTURE_WI_LIM;
 
-      for(i = TEXTURE_HI_START; i < TEXTURE_HI_LIM; i++)
+      for(i = ctx_->TEXTURE_HI_START; i < ctx_->TEXTURE_HI_LIM; i++)
         {
-          xcur   = (xvert + TEXTURE_WI_START * HDX1616);
-          ycur   = (yvert + TEXTURE_WI_START * HDY1616);
-          xvert += VDX1616;
-          yvert += VDY1616;
+          xcur   = (xvert + ctx_->TEXTURE_WI_START * ctx_->HDX1616);
+          ycur   = (yvert + ctx_->TEXTURE_WI_START * ctx_->HDY1616);
+          xvert += ctx_->VDX1616;
+          yvert += ctx_->VDY1616;
+
+          if(madam_band_skip_line_row(ctx_,ycur,(i == (ctx_->TEXTURE_HI_LIM - 1))))
+            continue;
 
-          for(j = TEXTURE_WI_START; j < SPRWI; j++)
+          for(j = ctx_->TEXTURE_WI_START; j < ctx_->SPRWI; j++)
             {
-              CURPIX = PDEC(mread16((PDATA + XY2OFF(j,i,offset << 2))),&LAMV);
+              CURPIX = ctx_->pdec.decode(ctx_,mread16((ctx_->SRCDATA + XY2OFF(j,i,ctx_->offset << 2))),&LAMV);
 
-              if(!pproj.Transparent)
+              if(!ctx_->pproj.Transparent && madam_band_test(ctx_,ycur >> 16))
                 {
                   uint32_t pixel;
                   uint32_t framePixel;
 
-                  if(FIXMODE & FIX_BIT_TIMING_6)
+                  if(!ctx_->pproc.fbread)
+                    framePixel = 0;
+                  else if(FIXMODE & FIX_BIT_TIMING_6)
                     framePixel = mread16((REGCTL2+XY2OFF(xcur >> 16,(ycur>>16)<<1,MADAM.rmod)));
                   else
                     framePixel = mread16((REGCTL2+XY2OFF(xcur >> 16,ycur>>16,MADAM.rmod)));
 
-                  pixel = PPROC(CURPIX,framePixel,LAMV);
-                  pixel = PPROJ_OUTPUT(CURPIX,pixel,framePixel);
+                  pixel = ctx_->pproc.process(ctx_,CURPIX,framePixel,LAMV);
                   mwrite16((REGCTL3+XY2OFF(xcur >> 16,ycur >> 16,MADAM.wmod)),pixel);
+                  MADAM_STAT_COUNT(ctx_,pixels,1);
                 }
 
-              xcur += HDX1616;
-              ycur += HDY1616;
+              xcur += ctx_->HDX1616;
+              ycur += ctx_->HDY1616;
             }
         }
       break;
@@ -2270,66 +3876,98 @@ DrawLRCel_New(void)
       {
         int32_t drawHeight;
 
-        drawHeight = VDY1616;
-        if((CCBFLAGS & CCB_MARIA) && (drawHeight > (1 << 16)))
+        drawHeight = ctx_->VDY1616;
+        if((ctx_->CCBFLAGS & CCB_MARIA) && (drawHeight > (1 << 16)))
           drawHeight = (1 << 16);
 
-        for(i = 0; i < SPRHI; i++)
+        for(i = 0; i < ctx_->SPRHI; i++)
           {
             xcur   = xvert;
             ycur   = yvert;
-            xvert += VDX1616;
-            yvert += VDY1616;
+            xvert += ctx_->VDX1616;
+            yvert += ctx_->VDY1616;
+
+            if(madam_band_skip_scale_row(ctx_,ycur,drawHeight,(i == (ctx_->SPRHI - 1))))
+              continue;
+
+            j0 = 0;
+            j1 = ctx_->SPRWI;
+            if(madam_cull_scale(ctx_,&cull,xcur,ycur,drawHeight) &&
+               madam_cull_columns(&cull,ctx_->SPRWI,(i == (ctx_->SPRHI - 1)),&j0,&j1))
+              {
+                madam_cull_count(ctx_,1,ctx_->SPRWI);
+                continue;
+              }
 
-            for(j = 0; j < SPRWI; j++)
+            madam_cull_count(ctx_,0,(ctx_->SPRWI - (j1 - j0)));
+            xcur += (ctx_->HDX1616 * j0);
+            ycur += (ctx_->HDY1616 * j0);
+
+            for(j = j0; j < j1; j++)
               {
-                CURPIX = PDEC(mread16((PDATA+XY2OFF(j,i,offset<<2))),&LAMV);
+                CURPIX = ctx_->pdec.decode(ctx_,mread16((ctx_->SRCDATA+XY2OFF(j,i,ctx_->offset<<2))),&LAMV);
 
-                if(!pproj.Transparent)
+                if(!ctx_->pproj.Transparent)
                   {
-                    if(TexelDraw_Scale(CURPIX,
+                    if(TexelDraw_Scale(ctx_,CURPIX,
                                        LAMV,
                                        xcur >> 16,
                                        ycur >> 16,
-                                       ((xcur+HDX1616+VDX1616)>>16),
-                                       ((ycur+HDY1616+drawHeight)>>16)))
+                                       ((xcur+ctx_->HDX1616+ctx_->VDX1616)>>16),
+                                       ((ycur+ctx_->HDY1616+drawHeight)>>16)))
                       break;
                   }
 
-                xcur += HDX1616;
-                ycur += HDY1616;
+                xcur += ctx_->HDX1616;
+                ycur += ctx_->HDY1616;
               }
           }
       }
       break;
     default:
-      for(i = 0; i < SPRHI; i++)
+      for(i = 0; i < ctx_->SPRHI; i++)
         {
-          xcur     = xvert;
-          ycur     = yvert;
-          xvert   += VDX1616;
-          yvert   += VDY1616;
-          xdown    = xvert;
-          ydown    = yvert;
-          hdx      = HDX1616;
-          hdy      = HDY1616;
-          HDX1616 += HDDX1616;
-          HDY1616 += HDDY1616;
-
-          for(j = 0; j < SPRWI; j++)
+          xcur           = xvert;
+          ycur           = yvert;
+          xvert         += ctx_->VDX1616;
+          yvert         += ctx_->VDY1616;
+          xdown          = xvert;
+          ydown          = yvert;
+          hdx            = ctx_->HDX1616;
+          hdy            = ctx_->HDY1616;
+          ctx_->HDX1616 += ctx_->HDDX1616;
+          ctx_->HDY1616 += ctx_->HDDY1616;
+
+          if(madam_band_skip_quad_row(ctx_,ycur,hdy,ydown,ctx_->SPRWI,(i == (ctx_->SPRHI - 1))))
+            continue;
+
+          madam_cull_quad(ctx_,&cull,xcur,ycur,hdx,hdy,xdown,ydown);
+          if(madam_cull_columns(&cull,ctx_->SPRWI,(i == (ctx_->SPRHI - 1)),&j0,&j1))
+            {
+              madam_cull_count(ctx_,1,ctx_->SPRWI);
+              continue;
+            }
+
+          madam_cull_count(ctx_,0,(ctx_->SPRWI - (j1 - j0)));
+          xcur  += (hdx * j0);
+          ycur  += (hdy * j0);
+          xdown += (ctx_->HDX1616 * j0);
+          ydown += (ctx_->HDY1616 * j0);
+
+          for(j = j0; j < j1; j++)
             {
-              CURPIX = PDEC(mread16((PDATA+XY2OFF(j,i,offset<<2))),&LAMV);
+              CURPIX = ctx_->pdec.decode(ctx_,mread16((ctx_->SRCDATA+XY2OFF(j,i,ctx_->offset<<2))),&LAMV);
 
-              if(!pproj.Transparent)
+              if(!ctx_->pproj.Transparent)
                 {
-                  if(TexelDraw_Arbitrary(CURPIX,
+                  if(TexelDraw_Arbitrary(ctx_,CURPIX,
                                          LAMV,
                                          xcur,
                                          ycur,
                                          xcur + hdx,
                                          ycur + hdy,
-                                         xdown + HDX1616,
-                                         ydown + HDY1616,
+                                         xdown + ctx_->HDX1616,
+                                         ydown + ctx_->HDY1616,
                                          xdown,
                                          ydown))
                     break;
@@ -2337,17 +3975,17 @@ DrawLRCel_New(void)
 
               xcur  += hdx;
               ycur  += hdy;
-              xdown += HDX1616;
-              ydown += HDY1616;
+              xdown += ctx_->HDX1616;
+              ydown += ctx_->HDY1616;
             }
         }
       break;
     }
 
   if(FIXMODE & FIX_BIT_GRAPHICS_STEP_Y)
-    YPOS1616 = ycur;
+    ctx_->YPOS1616 = ycur;
   else
-    XPOS1616 = xcur;
+    ctx_->XPOS1616 = xcur;
 }
 
 void
@@ -2355,42 +3993,110 @@ opera_madam_reset(void)
 {
   uint32_t i;
 
+  opera_madam_sync();
+  opera_madam_dram_dirty(0,MADAM_CACHE_END);
+
   for(i = 0; i < MADAM_REGISTER_COUNT; i++)
     MADAM.mregs[i] = 0;
 }
 
+/*
+  Signed 64x64 bit multiply, the 128 bit product split into hi_:lo_.
+*/
+static
+void
+madam_mul64(const int64_t  a_,
+            const int64_t  b_,
+            int64_t       *hi_,
+            uint64_t      *lo_)
+{
+  uint64_t a;
+  uint64_t b;
+  uint64_t hi;
+  uint64_t lo;
+  uint64_t mid;
+  uint64_t p00;
+  uint64_t p01;
+  uint64_t p10;
+
+  a = ((a_ < 0) ? -(uint64_t)a_ : (uint64_t)a_);
+  b = ((b_ < 0) ? -(uint64_t)b_ : (uint64_t)b_);
+
+  p00 = ((a & 0xFFFFFFFF) * (b & 0xFFFFFFFF));
+  p01 = ((a & 0xFFFFFFFF) * (b >> 32));
+  p10 = ((a >> 32) * (b & 0xFFFFFFFF));
+  mid = ((p00 >> 32) + (p01 & 0xFFFFFFFF) + (p10 & 0xFFFFFFFF));
+  lo  = ((mid << 32) | (p00 & 0xFFFFFFFF));
+  hi  = (((a >> 32) * (b >> 32)) + (p01 >> 32) + (p10 >> 32) + (mid >> 32));
+
+  if((a_ < 0) != (b_ < 0))
+    {
+      lo = (~lo + 1);
+      hi = (~hi + (lo == 0));
+    }
+
+  *hi_ = (int64_t)hi;
+  *lo_ = lo;
+}
+
+/*
+  Winding of the parallelogram spanned by the H and V vectors, all in
+  16.16. vdx_ * hdy_ - hdx_ * vdy_ is worked out exactly, the vectors
+  with the HDD terms added can take 49 bits.
+*/
 static
-INLINE
 uint32_t
-TexelCCWTest(const float hdx_,
-             const float hdy_,
-             const float vdx_,
-             const float vdy_)
+TexelCCWTest(const int64_t hdx_,
+             const int64_t hdy_,
+             const int64_t vdx_,
+             const int64_t vdy_)
 {
-  if(((hdx_ + vdx_) * (hdy_ - vdy_) + (vdx_ * vdy_) - (hdx_ * hdy_)) < 0.0)
+  int64_t  hi[2];
+  uint64_t lo[2];
+
+  madam_mul64(vdx_,hdy_,&hi[0],&lo[0]);
+  madam_mul64(hdx_,vdy_,&hi[1],&lo[1]);
+
+  if((hi[0] < hi[1]) || ((hi[0] == hi[1]) && (lo[0] < lo[1])))
     return CCB_ACCW;
   return CCB_ACW;
 }
 
 static
 bool_t
-QuardCCWTest(int32_t wdt_)
+QuardCCWTest(madam_ctx_t *ctx_,
+             int32_t      wdt_)
 {
-  float wdt;
+  int64_t  hdx;
+  int64_t  hdy;
+  int64_t  vdx;
+  int64_t  vdy;
+  int64_t  hddx;
+  int64_t  hddy;
+  int64_t  wdt;
+  int64_t  hi;
   uint32_t tmp;
 
-  if((CCBFLAGS & CCB_ACCW) && (CCBFLAGS & CCB_ACW))
+  if((ctx_->CCBFLAGS & CCB_ACCW) && (ctx_->CCBFLAGS & CCB_ACW))
     return FALSE;
 
-  wdt = (float)wdt_;
-  tmp = TexelCCWTest(HDX,HDY,VDX,VDY);
-  if(tmp != TexelCCWTest(HDX,HDY,VDX+HDDX*wdt,VDY+HDDY*wdt))
+  hdx  = ctx_->HDX1616;
+  hdy  = ctx_->HDY1616;
+  vdx  = ctx_->VDX1616;
+  vdy  = ctx_->VDY1616;
+  hddx = ctx_->HDDX1616;
+  hddy = ctx_->HDDY1616;
+  wdt  = wdt_;
+  hi   = ctx_->SPRHI;
+
+  tmp = TexelCCWTest(hdx,hdy,vdx,vdy);
+  if(tmp != TexelCCWTest(hdx,hdy,vdx+hddx*wdt,vdy+hddy*wdt))
     return FALSE;
-  if(tmp != TexelCCWTest(HDX+HDDX*SPRHI,HDY+HDDY*SPRHI,VDX,VDY))
+  if(tmp != TexelCCWTest(hdx+hddx*hi,hdy+hddy*hi,vdx,vdy))
     return FALSE;
-  if(tmp != TexelCCWTest(HDX+HDDX*SPRHI,HDY+HDDY*SPRHI,VDX+HDDX*(float)SPRHI*wdt,VDY+HDDY*(float)SPRHI*wdt))
+  if(tmp != TexelCCWTest(hdx+hddx*hi,hdy+hddy*hi,vdx+hddx*hi*wdt,vdy+hddy*hi*wdt))
     return FALSE;
-  if(tmp == (CCBFLAGS & (CCB_ACCW | CCB_ACW)))
+  if(tmp == (ctx_->CCBFLAGS & (CCB_ACCW | CCB_ACW)))
     return TRUE;
   return FALSE;
 }
@@ -2405,21 +4111,22 @@ ABS(const int32_t val_)
 
 static
 int32_t
-TestInitVisual(int32_t packed_)
+TestInitVisual(madam_ctx_t *ctx_,
+               int32_t      packed_)
 {
   int32_t xpoints[4];
   int32_t ypoints[4];
 
-  if(!(CCBFLAGS & CCB_ACCW) && !(CCBFLAGS & CCB_ACW))
+  if(!(ctx_->CCBFLAGS & CCB_ACCW) && !(ctx_->CCBFLAGS & CCB_ACW))
     return -1;
 
   if(!packed_)
     {
-      xpoints[0] = (XPOS1616 >> 16);
-      xpoints[1] = (XPOS1616+HDX1616*SPRWI)>>16;
-      xpoints[2] = (XPOS1616+VDX1616*SPRHI)>>16;
-      xpoints[3] = ((XPOS1616+VDX1616*SPRHI+
-                     (HDX1616+HDDX1616*SPRHI)*SPRWI) >> 16);
+      xpoints[0] = (ctx_->XPOS1616 >> 16);
+      xpoints[1] = (ctx_->XPOS1616+ctx_->HDX1616*ctx_->SPRWI)>>16;
+      xpoints[2] = (ctx_->XPOS1616+ctx_->VDX1616*ctx_->SPRHI)>>16;
+      xpoints[3] = ((ctx_->XPOS1616+ctx_->VDX1616*ctx_->SPRHI+
+                     (ctx_->HDX1616+ctx_->HDDX1616*ctx_->SPRHI)*ctx_->SPRWI) >> 16);
       if((xpoints[0] < 0) &&
          (xpoints[1] < 0) &&
          (xpoints[2] < 0) &&
@@ -2431,11 +4138,11 @@ TestInitVisual(int32_t packed_)
          (xpoints[3] > MADAM.clipx))
         return -1;
 
-      ypoints[0] = (YPOS1616 >> 16);
-      ypoints[1] = ((YPOS1616+HDY1616*SPRWI) >> 16);
-      ypoints[2] = ((YPOS1616+VDY1616*SPRHI) >> 16);
-      ypoints[3] = ((YPOS1616+VDY1616*SPRHI+
-                     (HDY1616+HDDY1616*SPRHI)*SPRWI) >> 16);
+      ypoints[0] = (ctx_->YPOS1616 >> 16);
+      ypoints[1] = ((ctx_->YPOS1616+ctx_->HDY1616*ctx_->SPRWI) >> 16);
+      ypoints[2] = ((ctx_->YPOS1616+ctx_->VDY1616*ctx_->SPRHI) >> 16);
+      ypoints[3] = ((ctx_->YPOS1616+ctx_->VDY1616*ctx_->SPRHI+
+                     (ctx_->HDY1616+ctx_->HDDY1616*ctx_->SPRHI)*ctx_->SPRWI) >> 16);
       if((ypoints[0] < 0) &&
          (ypoints[1] < 0) &&
          (ypoints[2] < 0) &&
@@ -2449,68 +4156,68 @@ TestInitVisual(int32_t packed_)
     }
   else
     {
-      xpoints[0] = (XPOS1616 >> 16);
-      xpoints[1] = ((XPOS1616 + VDX1616 * SPRHI) >> 16);
-      if((xpoints[0] < 0) &&
-         (xpoints[1] < 0) &&
-         (HDX1616   <= 0) &&
-         (HDDX1616  <= 0))
+      xpoints[0] = (ctx_->XPOS1616 >> 16);
+      xpoints[1] = ((ctx_->XPOS1616 + ctx_->VDX1616 * ctx_->SPRHI) >> 16);
+      if((xpoints[0] < 0)      &&
+         (xpoints[1] < 0)      &&
+         (ctx_->HDX1616  <= 0) &&
+         (ctx_->HDDX1616 <= 0))
         return -1;
       if((xpoints[0] > MADAM.clipx) &&
          (xpoints[1] > MADAM.clipx) &&
-         (HDX1616   >= 0)           &&
-         (HDDX1616  >= 0))
+         (ctx_->HDX1616  >= 0)      &&
+         (ctx_->HDDX1616 >= 0))
         return -1;
 
-      ypoints[0] = (YPOS1616 >> 16);
-      ypoints[1] = ((YPOS1616 + VDY1616 * SPRHI) >> 16);
-      if((ypoints[0] < 0) &&
-         (ypoints[1] < 0) &&
-         (HDY1616   <= 0) &&
-         (HDDY1616  <= 0))
+      ypoints[0] = (ctx_->YPOS1616 >> 16);
+      ypoints[1] = ((ctx_->YPOS1616 + ctx_->VDY1616 * ctx_->SPRHI) >> 16);
+      if((ypoints[0] < 0)      &&
+         (ypoints[1] < 0)      &&
+         (ctx_->HDY1616  <= 0) &&
+         (ctx_->HDDY1616 <= 0))
         return -1;
       if((ypoints[0] > MADAM.clipy) &&
          (ypoints[1] > MADAM.clipy) &&
-         (HDY1616   >= 0)           &&
-         (HDDY1616  >= 0))
+         (ctx_->HDY1616  >= 0)      &&
+         (ctx_->HDDY1616 >= 0))
         return -1;
     }
 
-  if((HDDX1616 == 0) && (HDDY1616 == 0))
+  if((ctx_->HDDX1616 == 0) && (ctx_->HDDY1616 == 0))
     {
-      if((HDX1616 == 0) && (VDY1616 == 0))
+      if((ctx_->HDX1616 == 0) && (ctx_->VDY1616 == 0))
         {
-          if(((HDY1616 < 0) && (VDX1616 > 0)) ||
-             ((HDY1616 > 0) && (VDX1616 < 0)))
+          if(((ctx_->HDY1616 < 0) && (ctx_->VDX1616 > 0)) ||
+             ((ctx_->HDY1616 > 0) && (ctx_->VDX1616 < 0)))
             {
-              if(CCBFLAGS & CCB_ACW)
+              if(ctx_->CCBFLAGS & CCB_ACW)
                 {
-                  if((ABS(HDY1616) == 0x10000) &&
-                     (ABS(VDX1616) == 0x10000) &&
-                     !((YPOS1616|XPOS1616)&0xffff))
+                  if((ABS(ctx_->HDY1616) == 0x10000) &&
+                     (ABS(ctx_->VDX1616) == 0x10000) &&
+                     !((ctx_->YPOS1616|ctx_->XPOS1616)&0xffff))
                     {
-                      return Init_Line_Map();
+                      return Init_Line_Map(ctx_);
                     }
                   else
                     {
-                      Init_Scale_Map();
+                      Init_Scale_Map(ctx_);
                       return 0;
                     }
                 }
             }
           else
             {
-              if(CCBFLAGS & CCB_ACCW)
+              if(ctx_->CCBFLAGS & CCB_ACCW)
                 {
-                  if((ABS(HDY1616) == 0x10000) &&
-                     (ABS(VDX1616) == 0x10000) &&
-                     !((YPOS1616|XPOS1616)&0xffff))
+                  if((ABS(ctx_->HDY1616) == 0x10000) &&
+                     (ABS(ctx_->VDX1616) == 0x10000) &&
+                     !((ctx_->YPOS1616|ctx_->XPOS1616)&0xffff))
                     {
-                      return Init_Line_Map();
+                      return Init_Line_Map(ctx_);
                     }
                   else
                     {
-                      Init_Scale_Map();
+                      Init_Scale_Map(ctx_);
                       return 0;
                     }
                 }
@@ -2518,39 +4225,39 @@ TestInitVisual(int32_t packed_)
 
           return -1;
         }
-      else if((HDY1616 == 0) && (VDX1616 == 0))
+      else if((ctx_->HDY1616 == 0) && (ctx_->VDX1616 == 0))
         {
-          if(((HDX1616 < 0) && (VDY1616 > 0)) ||
-             ((HDX1616 > 0) && (VDY1616 < 0)))
+          if(((ctx_->HDX1616 < 0) && (ctx_->VDY1616 > 0)) ||
+             ((ctx_->HDX1616 > 0) && (ctx_->VDY1616 < 0)))
             {
-              if(CCBFLAGS & CCB_ACCW)
+              if(ctx_->CCBFLAGS & CCB_ACCW)
                 {
-                  if((ABS(HDX1616) == 0x10000) &&
-                     (ABS(VDY1616) == 0x10000) &&
-                     !((YPOS1616|XPOS1616)&0xffff))
+                  if((ABS(ctx_->HDX1616) == 0x10000) &&
+                     (ABS(ctx_->VDY1616) == 0x10000) &&
+                     !((ctx_->YPOS1616|ctx_->XPOS1616)&0xffff))
                     {
-                      return Init_Line_Map();
+                      return Init_Line_Map(ctx_);
                     }
                   else
                     {
-                      Init_Scale_Map();
+                      Init_Scale_Map(ctx_);
                       return 0;
                     }
                 }
             }
           else
             {
-              if(CCBFLAGS & CCB_ACW)
+              if(ctx_->CCBFLAGS & CCB_ACW)
                 {
-                  if((ABS(HDX1616) == 0x10000) &&
-                     (ABS(VDY1616) == 0x10000) &&
-                     !((YPOS1616|XPOS1616)&0xffff))
+                  if((ABS(ctx_->HDX1616) == 0x10000) &&
+                     (ABS(ctx_->VDY1616) == 0x10000) &&
+                     !((ctx_->YPOS1616|ctx_->XPOS1616)&0xffff))
                     {
-                      return Init_Line_Map();
+                      return Init_Line_Map(ctx_);
                     }
                   else
                     {
-                      Init_Scale_Map();
+                      Init_Scale_Map(ctx_);
                       return 0;
                     }
                 }
@@ -2560,112 +4267,112 @@ TestInitVisual(int32_t packed_)
         }
     }
 
-  if(QuardCCWTest(!packed_ ? SPRWI : 2048))
+  if(QuardCCWTest(ctx_,!packed_ ? ctx_->SPRWI : 2048))
     return -1;
 
-  Init_Arbitrary_Map();
+  Init_Arbitrary_Map(ctx_);
 
   return 0;
 }
 
 static
 int32_t
-Init_Line_Map(void)
+Init_Line_Map(madam_ctx_t *ctx_)
 {
-  TEXEL_FUN_NUMBER = 0;
-  TEXTURE_WI_START = 0;
-  TEXTURE_HI_START = 0;
-  TEXTURE_HI_LIM   = SPRHI;
+  ctx_->TEXEL_FUN_NUMBER = 0;
+  ctx_->TEXTURE_WI_START = 0;
+  ctx_->TEXTURE_HI_START = 0;
+  ctx_->TEXTURE_HI_LIM   = ctx_->SPRHI;
 
-  if((HDX1616 < 0) || (VDX1616 < 0))
-    XPOS1616 -= 0x8000;
-  if((HDY1616 < 0) || (VDY1616 < 0))
-    YPOS1616 -= 0x8000;
+  if((ctx_->HDX1616 < 0) || (ctx_->VDX1616 < 0))
+    ctx_->XPOS1616 -= 0x8000;
+  if((ctx_->HDY1616 < 0) || (ctx_->VDY1616 < 0))
+    ctx_->YPOS1616 -= 0x8000;
 
-  if(VDX1616 < 0)
+  if(ctx_->VDX1616 < 0)
     {
-      if(((XPOS1616 - ((SPRHI - 1) << 16)) >> 16) < 0)
-        TEXTURE_HI_LIM = ((XPOS1616 >> 16) + 1);
-      if(TEXTURE_HI_LIM > SPRHI)
-        TEXTURE_HI_LIM = SPRHI;
+      if(((ctx_->XPOS1616 - ((ctx_->SPRHI - 1) << 16)) >> 16) < 0)
+        ctx_->TEXTURE_HI_LIM = ((ctx_->XPOS1616 >> 16) + 1);
+      if(ctx_->TEXTURE_HI_LIM > ctx_->SPRHI)
+        ctx_->TEXTURE_HI_LIM = ctx_->SPRHI;
     }
-  else if(VDX1616 > 0)
+  else if(ctx_->VDX1616 > 0)
     {
-      if(((XPOS1616 + (SPRHI << 16)) >> 16) > MADAM.clipx)
-        TEXTURE_HI_LIM = (MADAM.clipx - (XPOS1616>>16) + 1);
+      if(((ctx_->XPOS1616 + (ctx_->SPRHI << 16)) >> 16) > MADAM.clipx)
+        ctx_->TEXTURE_HI_LIM = (MADAM.clipx - (ctx_->XPOS1616>>16) + 1);
     }
 
-  if(VDY1616 < 0)
+  if(ctx_->VDY1616 < 0)
     {
-      if((((YPOS1616) - ((SPRHI - 1) << 16)) >> 16) < 0)
-        TEXTURE_HI_LIM = ((YPOS1616 >> 16) + 1);
-      if(TEXTURE_HI_LIM > SPRHI)
-        TEXTURE_HI_LIM = SPRHI;
+      if((((ctx_->YPOS1616) - ((ctx_->SPRHI - 1) << 16)) >> 16) < 0)
+        ctx_->TEXTURE_HI_LIM = ((ctx_->YPOS1616 >> 16) + 1);
+      if(ctx_->TEXTURE_HI_LIM > ctx_->SPRHI)
+        ctx_->TEXTURE_HI_LIM = ctx_->SPRHI;
     }
-  else if(VDY1616 > 0)
+  else if(ctx_->VDY1616 > 0)
     {
-      if(((YPOS1616 + (SPRHI << 16)) >> 16) > MADAM.clipy)
-        TEXTURE_HI_LIM = (MADAM.clipy - (YPOS1616 >> 16) + 1);
+      if(((ctx_->YPOS1616 + (ctx_->SPRHI << 16)) >> 16) > MADAM.clipy)
+        ctx_->TEXTURE_HI_LIM = (MADAM.clipy - (ctx_->YPOS1616 >> 16) + 1);
     }
 
-  if(HDX1616 < 0)
-    TEXTURE_WI_LIM = ((XPOS1616 >> 16) + 1);
-  else if(HDX1616 > 0)
-    TEXTURE_WI_LIM = (MADAM.clipx - (XPOS1616 >> 16) + 1);
+  if(ctx_->HDX1616 < 0)
+    ctx_->TEXTURE_WI_LIM = ((ctx_->XPOS1616 >> 16) + 1);
+  else if(ctx_->HDX1616 > 0)
+    ctx_->TEXTURE_WI_LIM = (MADAM.clipx - (ctx_->XPOS1616 >> 16) + 1);
 
-  if(HDY1616 < 0)
-    TEXTURE_WI_LIM = ((YPOS1616 >> 16) + 1);
-  else if(HDY1616 > 0)
-    TEXTURE_WI_LIM = (MADAM.clipy - (YPOS1616 >> 16) + 1);
+  if(ctx_->HDY1616 < 0)
+    ctx_->TEXTURE_WI_LIM = ((ctx_->YPOS1616 >> 16) + 1);
+  else if(ctx_->HDY1616 > 0)
+    ctx_->TEXTURE_WI_LIM = (MADAM.clipy - (ctx_->YPOS1616 >> 16) + 1);
 
-  if(XPOS1616 < 0)
+  if(ctx_->XPOS1616 < 0)
     {
-      if(HDX1616 < 0)
+      if(ctx_->HDX1616 < 0)
         return -1;
-      else if(HDX1616 > 0)
-        TEXTURE_WI_START = -(XPOS1616 >> 16);
+      else if(ctx_->HDX1616 > 0)
+        ctx_->TEXTURE_WI_START = -(ctx_->XPOS1616 >> 16);
 
-      if(VDX1616 < 0)
+      if(ctx_->VDX1616 < 0)
         return -1;
-      else if(VDX1616 > 0)
-        TEXTURE_HI_START = -(XPOS1616 >> 16);
+      else if(ctx_->VDX1616 > 0)
+        ctx_->TEXTURE_HI_START = -(ctx_->XPOS1616 >> 16);
     }
-  else if((XPOS1616 >> 16) > MADAM.clipx)
+  else if((ctx_->XPOS1616 >> 16) > MADAM.clipx)
     {
-      if(HDX1616 > 0)
+      if(ctx_->HDX1616 > 0)
         return -1;
-      else if(HDX1616 < 0)
-        TEXTURE_WI_START = ((XPOS1616 >> 16) - MADAM.clipx);
+      else if(ctx_->HDX1616 < 0)
+        ctx_->TEXTURE_WI_START = ((ctx_->XPOS1616 >> 16) - MADAM.clipx);
 
-      if(VDX1616 > 0)
+      if(ctx_->VDX1616 > 0)
         return -1;
-      else if(VDX1616 < 0)
-        TEXTURE_HI_START = ((XPOS1616 >> 16) - MADAM.clipx);
+      else if(ctx_->VDX1616 < 0)
+        ctx_->TEXTURE_HI_START = ((ctx_->XPOS1616 >> 16) - MADAM.clipx);
     }
 
-  if(YPOS1616 < 0)
+  if(ctx_->YPOS1616 < 0)
     {
-      if(HDY1616 < 0)
+      if(ctx_->HDY1616 < 0)
         return -1;
-      else if(HDY1616 > 0)
-        TEXTURE_WI_START = -(YPOS1616 >> 16);
+      else if(ctx_->HDY1616 > 0)
+        ctx_->TEXTURE_WI_START = -(ctx_->YPOS1616 >> 16);
 
-      if(VDY1616 < 0)
+      if(ctx_->VDY1616 < 0)
         return -1;
-      else if(VDY1616 > 0)
-        TEXTURE_HI_START = -(YPOS1616 >> 16);
+      else if(ctx_->VDY1616 > 0)
+        ctx_->TEXTURE_HI_START = -(ctx_->YPOS1616 >> 16);
     }
-  else if((YPOS1616 >> 16) > MADAM.clipy)
+  else if((ctx_->YPOS1616 >> 16) > MADAM.clipy)
     {
-      if(HDY1616 > 0)
+      if(ctx_->HDY1616 > 0)
         return -1;
-      else if(HDY1616 < 0)
-        TEXTURE_WI_START = ((YPOS1616 >> 16) - MADAM.clipy);
+      else if(ctx_->HDY1616 < 0)
+        ctx_->TEXTURE_WI_START = ((ctx_->YPOS1616 >> 16) - MADAM.clipy);
 
-      if(VDY1616 > 0)
+      if(ctx_->VDY1616 > 0)
         return -1;
-      else if(VDY1616 < 0)
-        TEXTURE_HI_START = ((YPOS1616 >> 16) - MADAM.clipy);
+      else if(ctx_->VDY1616 < 0)
+        ctx_->TEXTURE_HI_START = ((ctx_->YPOS1616 >> 16) - MADAM.clipy);
     }
 
   /*
@@ -2677,7 +4384,7 @@ Init_Line_Map(void)
     if(TEXTURE_HI_LIM>SPRHI)TEXTURE_HI_LIM=SPRHI;
   */
 
-  if(TEXTURE_WI_LIM <= 0)
+  if(ctx_->TEXTURE_WI_LIM <= 0)
     return -1;
 
   return 0;
@@ -2686,47 +4393,49 @@ Init_Line_Map(void)
 static
 INLINE
 void
-Init_Scale_Map(void)
+Init_Scale_Map(madam_ctx_t *ctx_)
 {
   int32_t deltax;
   int32_t deltay;
 
-  TEXEL_FUN_NUMBER = 1;
+  ctx_->TEXEL_FUN_NUMBER = 1;
 
-  if((HDX1616 < 0) || (VDX1616 < 0))
-    XPOS1616 -= 0x8000;
-  if((HDY1616 < 0) || (VDY1616 < 0))
-    YPOS1616 -= 0x8000;
+  if((ctx_->HDX1616 < 0) || (ctx_->VDX1616 < 0))
+    ctx_->XPOS1616 -= 0x8000;
+  if((ctx_->HDY1616 < 0) || (ctx_->VDY1616 < 0))
+    ctx_->YPOS1616 -= 0x8000;
 
-  deltax = (HDX1616 + VDX1616);
-  deltay = (HDY1616 + VDY1616);
+  deltax = (ctx_->HDX1616 + ctx_->VDX1616);
+  deltay = (ctx_->HDY1616 + ctx_->VDY1616);
 
-  TEXEL_INCX = ((deltax < 0) ? -1 : 1);
-  TEXEL_INCY = ((deltay < 0) ? -1 : 1);
+  ctx_->TEXEL_INCX = ((deltax < 0) ? -1 : 1);
+  ctx_->TEXEL_INCY = ((deltay < 0) ? -1 : 1);
 
-  TEXTURE_WI_START = 0;
-  TEXTURE_HI_START = 0;
+  ctx_->TEXTURE_WI_START = 0;
+  ctx_->TEXTURE_HI_START = 0;
 }
 
 static
 INLINE
 void
-Init_Arbitrary_Map(void)
+Init_Arbitrary_Map(madam_ctx_t *ctx_)
 {
-  TEXEL_FUN_NUMBER = 2;
-  TEXTURE_WI_START = 0;
-  TEXTURE_HI_START = 0;
+  ctx_->TEXEL_FUN_NUMBER = 2;
+  ctx_->TEXTURE_WI_START = 0;
+  ctx_->TEXTURE_HI_START = 0;
 }
 
 static
 void
-TexelDraw_Line(uint16_t CURPIX_,
-               uint16_t LAMV_,
-               int32_t  xcur_,
-               int32_t  ycur_,
-               int32_t  cnt_)
+TexelDraw_Line(madam_ctx_t *ctx_,
+               uint16_t     CURPIX_,
+               uint16_t     LAMV_,
+               int32_t      xcur_,
+               int32_t      ycur_,
+               int32_t      cnt_)
 {
   int32_t i;
+  int32_t n;
   uint32_t curr;
   uint32_t pixel;
 
@@ -2734,20 +4443,26 @@ TexelDraw_Line(uint16_t CURPIX_,
   ycur_ >>= 16;
   curr = 0xFFFFFFFF;
 
-  for(i = 0; i < cnt_; i++, xcur_ += (HDX1616 >> 16), ycur_ += (HDY1616 >> 16))
+  for(i = 0, n = 0; i < cnt_; i++, xcur_ += (ctx_->HDX1616 >> 16), ycur_ += (ctx_->HDY1616 >> 16))
     {
       uint32_t next;
 
-      next = mread16(REGCTL2 + XY2OFF(xcur_,ycur_,MADAM.rmod));
+      if(!madam_band_test(ctx_,ycur_))
+        continue;
+
+      n++;
+
+      next = (ctx_->pproc.fbread ? mread16(REGCTL2 + XY2OFF(xcur_,ycur_,MADAM.rmod)) : 0);
       if(next != curr)
         {
           curr  = next;
-          pixel = PPROC(CURPIX_,next,LAMV_);
-          pixel = PPROJ_OUTPUT(CURPIX_,pixel,next);
+          pixel = ctx_->pproc.process(ctx_,CURPIX_,next,LAMV_);
         }
 
       mwrite16(REGCTL3 + XY2OFF(xcur_,ycur_,MADAM.wmod),pixel);
     }
+
+  MADAM_STAT_COUNT(ctx_,pixels,n);
 }
 
 static
@@ -2795,15 +4510,17 @@ writePIX(int32_t  x_,
 
 static
 int32_t
-TexelDraw_Scale(uint16_t CURPIX_,
-                uint16_t LAMV_,
-                int32_t  xcur_,
-                int32_t  ycur_,
-                int32_t  deltax_,
-                int32_t  deltay_)
+TexelDraw_Scale(madam_ctx_t *ctx_,
+                uint16_t     CURPIX_,
+                uint16_t     LAMV_,
+                int32_t      xcur_,
+                int32_t      ycur_,
+                int32_t      deltax_,
+                int32_t      deltay_)
 {
   int32_t x;
   int32_t y;
+  int32_t n;
   uint32_t pixel;
   uint32_t framePixel;
 
@@ -2813,60 +4530,247 @@ TexelDraw_Scale(uint16_t CURPIX_,
       ycur_   *= 5;
     }
 
-  if((HDX1616 < 0) && (deltax_ < 0) && (xcur_ < 0))
+  if((ctx_->HDX1616 < 0) && (deltax_ < 0) && (xcur_ < 0))
     return -1;
-  else if((HDY1616 < 0) && (deltay_ < 0) && (ycur_ < 0))
+  else if((ctx_->HDY1616 < 0) && (deltay_ < 0) && (ycur_ < 0))
     return -1;
-  else if((HDX1616 > 0) && (deltax_ > MADAM.clipx) && (xcur_ > MADAM.clipx))
+  else if((ctx_->HDX1616 > 0) && (deltax_ > MADAM.clipx) && (xcur_ > MADAM.clipx))
     return -1;
-  else if((HDY1616 > 0) && (deltay_ > MADAM.clipy) && (ycur_ > MADAM.clipy))
+  else if((ctx_->HDY1616 > 0) && (deltay_ > MADAM.clipy) && (ycur_ > MADAM.clipy))
     return -1;
 
   if(xcur_ == deltax_)
     return 0;
 
-  for(y = ycur_; y != deltay_; y += TEXEL_INCY)
+  /* without frame buffer input every pixel of the texel is the same */
+  if(!ctx_->pproc.fbread)
+    pixel = ctx_->pproc.process(ctx_,CURPIX_,0,LAMV_);
+
+  n = 0;
+  for(y = ycur_; y != deltay_; y += ctx_->TEXEL_INCY)
     {
-      for(x = xcur_; x != deltax_; x += TEXEL_INCX)
+      for(x = xcur_; x != deltax_; x += ctx_->TEXEL_INCX)
         {
-          if(!TESTCLIP(x,y))
+          if(!TESTCLIP(x,y) || !madam_band_test(ctx_,y))
             continue;
 
-          process_pixel(x,y,CURPIX_,LAMV_);
+          n++;
+          if(ctx_->pproc.fbread)
+            {
+              framePixel = mread16(REGCTL2 + XY2OFF(x,y,MADAM.rmod));
+              pixel      = ctx_->pproc.process(ctx_,CURPIX_,framePixel,LAMV_);
+            }
+
+          mwrite16(REGCTL3 + XY2OFF(x,y,MADAM.wmod),pixel);
         }
     }
 
+  MADAM_STAT_COUNT(ctx_,pixels,n);
+
   return 0;
 }
 
+/*
+  Edges of a TexelDraw_Arbitrary() quad
+
+  An edge from (x1,y1) to (x2,y2) crosses row y when y lies in
+  [ylo,yhi) and does so at xlo + dx * (y - ylo) / dy counting from
+  its upper end, the division truncating. That is the row crossing of
+  the edge function (x - xlo) * dy - dx * (y - ylo) with the rounding
+  folded in. Texels rarely cover more than a row or two so crossings
+  are computed as needed rather than stepped. match is set when a
+  span starting at the edge is drawn for the winding the CCB allows.
+*/
+struct madam_edges_s
+{
+  int32_t ylo[4];
+  int32_t yhi[4];
+  int32_t xlo[4];
+  int32_t dx[4];
+  bool_t  match[4];
+};
+
+/* the edges crossing a row, paired in edge order, by crossing mask */
+static const uint8_t g_EDGE_PAIRS[16][2] =
+  {
+    {0,0},{0,0},{0,0},{0,1},
+    {0,0},{0,2},{1,2},{0,0},
+    {0,0},{0,3},{1,3},{0,0},
+    {2,3},{0,0},{0,0},{0,1}
+  };
+
+static
+FORCEINLINE
+void
+madam_edge_setup(madam_ctx_t          *ctx_,
+                 struct madam_edges_s *e_,
+                 const int32_t         i_,
+                 const int32_t         x1_,
+                 const int32_t         y1_,
+                 const int32_t         x2_,
+                 const int32_t         y2_)
+{
+  if(y1_ < y2_)
+    {
+      e_->ylo[i_] = y1_;
+      e_->yhi[i_] = y2_;
+      e_->xlo[i_] = x1_;
+      e_->dx[i_]  = (x2_ - x1_);
+    }
+  else
+    {
+      e_->ylo[i_] = y2_;
+      e_->yhi[i_] = y1_;
+      e_->xlo[i_] = x2_;
+      e_->dx[i_]  = (x1_ - x2_);
+    }
+
+  e_->match[i_] = (((ctx_->CCBFLAGS & CCB_ACW)  && (y1_ >= y2_)) ||
+                   ((ctx_->CCBFLAGS & CCB_ACCW) && (y1_ <  y2_)));
+}
+
+static
+FORCEINLINE
+uint32_t
+madam_edges_crossing(const struct madam_edges_s *e_,
+                     const int32_t               y_)
+{
+  int32_t  i;
+  uint32_t mask;
+
+  mask = 0;
+  for(i = 0; i < 4; i++)
+    mask |= (((y_ >= e_->ylo[i]) & (y_ < e_->yhi[i])) << i);
+
+  return mask;
+}
+
 static
+FORCEINLINE
 int32_t
-TexelDraw_Arbitrary(uint16_t CURPIX_,
-                    uint16_t LAMV_,
-                    int32_t  xA_,
-                    int32_t  yA_,
-                    int32_t  xB_,
-                    int32_t  yB_,
-                    int32_t  xC_,
-                    int32_t  yC_,
-                    int32_t  xD_,
-                    int32_t  yD_)
+madam_edge_x(const struct madam_edges_s *e_,
+             const int32_t               i_,
+             const int32_t               y_)
 {
-  int32_t x;
-  int32_t y;
-  int32_t miny;
-  int32_t maxy;
-  int32_t maxx;
-  int32_t maxxt;
-  int32_t maxyt;
-  int32_t tmp;
+  return (e_->xlo[i_] +
+          ((e_->dx[i_] * (y_ - e_->ylo[i_])) / (e_->yhi[i_] - e_->ylo[i_])));
+}
+
+/*
+  Draw [x_,maxx_) of line y_. The pixel processor only depends on the
+  frame buffer pixel so the last result is kept in curr_ and pixel_.
+*/
+static
+FORCEINLINE
+void
+madam_arbitrary_span(madam_ctx_t    *ctx_,
+                     int32_t         x_,
+                     int32_t         maxx_,
+                     const int32_t   y_,
+                     const uint16_t  CURPIX_,
+                     const uint16_t  LAMV_,
+                     uint32_t       *curr_,
+                     uint32_t       *pixel_)
+{
+  uint32_t  next;
+  uint16_t *src;
+  uint16_t *dst;
+
+  if(x_ < 0)
+    x_ = 0;
+
+  if(x_ >= maxx_)
+    return;
+
+  MADAM_STAT_COUNT(ctx_,pixels,(maxx_ - x_));
+
+  if(!ctx_->pproc.fbread)
+    {
+      if(*curr_ != 0)
+        {
+          *curr_  = 0;
+          *pixel_ = ctx_->pproc.process(ctx_,CURPIX_,0,LAMV_);
+        }
+
+      if(HIRESMODE)
+        {
+          for(; x_ < maxx_; x_++)
+            writePIX(x_,y_,*pixel_);
+          return;
+        }
+
+      dst = (uint16_t*)&DRAM[(REGCTL3 + XY2OFF(x_,y_,MADAM.wmod)) ^ 2];
+      for(; x_ < maxx_; x_++, dst += 2)
+        *dst = *pixel_;
+
+      return;
+    }
+
+  if(HIRESMODE)
+    {
+      for(; x_ < maxx_; x_++)
+        {
+          next = readPIX(x_,y_);
+          if(next != *curr_)
+            {
+              *curr_  = next;
+              *pixel_ = ctx_->pproc.process(ctx_,CURPIX_,next,LAMV_);
+            }
+          writePIX(x_,y_,*pixel_);
+        }
+
+      return;
+    }
+
+  /* neighbouring pixels of a line are a word apart */
+  src = (uint16_t*)&DRAM[(REGCTL2 + XY2OFF(x_,y_,MADAM.rmod)) ^ 2];
+  dst = (uint16_t*)&DRAM[(REGCTL3 + XY2OFF(x_,y_,MADAM.wmod)) ^ 2];
+  for(; x_ < maxx_; x_++)
+    {
+      next = *src;
+      if(next != *curr_)
+        {
+          *curr_  = next;
+          *pixel_ = ctx_->pproc.process(ctx_,CURPIX_,next,LAMV_);
+        }
+      *dst = *pixel_;
+
+      src += 2;
+      dst += 2;
+    }
+}
+
+static
+int32_t
+TexelDraw_Arbitrary(madam_ctx_t *ctx_,
+                    uint16_t     CURPIX_,
+                    uint16_t     LAMV_,
+                    int32_t      xA_,
+                    int32_t      yA_,
+                    int32_t      xB_,
+                    int32_t      yB_,
+                    int32_t      xC_,
+                    int32_t      yC_,
+                    int32_t      xD_,
+                    int32_t      yD_)
+{
+  int32_t  a;
+  int32_t  b;
+  int32_t  x;
+  int32_t  y;
+  int32_t  tmp;
+  int32_t  maxx;
+  int32_t  miny;
+  int32_t  maxy;
+  int32_t  maxxt;
+  int32_t  maxyt;
+  uint32_t mask;
   uint32_t curr;
-  uint32_t next;
   uint32_t pixel;
-  int32_t xpoints[4];
-  int32_t updowns[4];
+  struct madam_edges_s edges;
 
-  curr = -1;
+  curr  = -1;
+  pixel = 0;
   xA_ >>= (16 - HIRESMODE);
   xB_ >>= (16 - HIRESMODE);
   xC_ >>= (16 - HIRESMODE);
@@ -2882,25 +4786,25 @@ TexelDraw_Arbitrary(uint16_t CURPIX_,
   maxxt = ((MADAM.clipx + 1) << HIRESMODE);
   maxyt = ((MADAM.clipy + 1) << HIRESMODE);
 
-  if((HDX1616 < 0) && (HDDX1616 < 0))
+  if((ctx_->HDX1616 < 0) && (ctx_->HDDX1616 < 0))
     {
       if((xA_ < 0) && (xB_ < 0) && (xC_ < 0) && (xD_ < 0))
         return -1;
     }
 
-  if((HDX1616 > 0) && (HDDX1616 > 0))
+  if((ctx_->HDX1616 > 0) && (ctx_->HDDX1616 > 0))
     {
       if((xA_ >= maxxt) && (xB_ >= maxxt) && (xC_ >= maxxt) && (xD_ >= maxxt))
         return -1;
     }
 
-  if((HDY1616 < 0) && (HDDY1616 < 0))
+  if((ctx_->HDY1616 < 0) && (ctx_->HDDY1616 < 0))
     {
       if((yA_ < 0) && (yB_ < 0) && (yC_ < 0) && (yD_ < 0))
         return -1;
     }
 
-  if((HDY1616 > 0) && (HDDY1616 > 0))
+  if((ctx_->HDY1616 > 0) && (ctx_->HDDY1616 > 0))
     {
       if((yA_ >= maxyt) && (yB_ >= maxyt) && (yC_ >= maxyt) && (yD_ >= maxyt))
         return -1;
@@ -2926,121 +4830,49 @@ TexelDraw_Arbitrary(uint16_t CURPIX_,
     y = 0;
   if(maxy < maxyt)
     maxyt = maxy;
+  madam_band_clamp(ctx_,&y,&maxyt);
+  if(y >= maxyt)
+    return 0;
+
+  madam_edge_setup(ctx_,&edges,0,xA_,yA_,xB_,yB_);
+  madam_edge_setup(ctx_,&edges,1,xB_,yB_,xC_,yC_);
+  madam_edge_setup(ctx_,&edges,2,xC_,yC_,xD_,yD_);
+  madam_edge_setup(ctx_,&edges,3,xD_,yD_,xA_,yA_);
 
   for(; y < maxyt; y++)
     {
-      int cnt_cross = 0;
-      if((y < yB_) && (y >= yA_))
-        {
-          xpoints[cnt_cross] = (int32_t)((((xB_-xA_)*(y-yA_))/(yB_-yA_))+xA_);
-          updowns[cnt_cross++] = 1;
-        }
-      else if((y >= yB_) && (y < yA_))
-        {
-          xpoints[cnt_cross] = (int32_t)((((xA_-xB_)*(y-yB_))/(yA_-yB_))+xB_);
-          updowns[cnt_cross++] = 0;
-        }
-
-      if((y < yC_) && (y >= yB_))
-        {
-          xpoints[cnt_cross] = (int32_t)((((xC_-xB_)*(y-yB_))/(yC_-yB_))+xB_);
-          updowns[cnt_cross++] = 1;
-        }
-      else if((y >= yC_) && (y < yB_))
-        {
-          xpoints[cnt_cross] = (int32_t)((((xB_-xC_)*(y-yC_))/(yB_-yC_))+xC_);
-          updowns[cnt_cross++] = 0;
-        }
+      /* a closed outline crosses a line an even number of times */
+      mask = madam_edges_crossing(&edges,y);
+      if(mask == 0)
+        continue;
 
-      if((y < yD_) && (y >= yC_))
-        {
-          xpoints[cnt_cross] = (int32_t)((((xD_-xC_)*(y-yC_))/(yD_-yC_))+xC_);
-          updowns[cnt_cross++] = 1;
-        }
-      else if((y >= yD_) && (y < yC_))
+      /*
+        Crossings pair up in edge order. Only the first pair is
+        ordered, as ever, and the second is drawn first.
+      */
+      if((mask == 0xF) && edges.match[2])
         {
-          xpoints[cnt_cross] = (int32_t)((((xC_-xD_)*(y-yD_))/(yC_-yD_))+xD_);
-          updowns[cnt_cross++] = 0;
+          x    = madam_edge_x(&edges,2,y);
+          maxx = madam_edge_x(&edges,3,y);
+          madam_arbitrary_span(ctx_,x,((maxx > maxxt) ? maxxt : maxx),
+                               y,CURPIX_,LAMV_,&curr,&pixel);
         }
 
-      if(cnt_cross & 1)
+      a    = g_EDGE_PAIRS[mask][0];
+      b    = g_EDGE_PAIRS[mask][1];
+      x    = madam_edge_x(&edges,a,y);
+      maxx = madam_edge_x(&edges,b,y);
+      if(x > maxx)
         {
-          if((y < yA_) && (y >= yD_))
-            {
-              xpoints[cnt_cross] = (int32_t)((((xA_-xD_)*(y-yD_))/(yA_-yD_))+xD_);
-              updowns[cnt_cross] = 1;
-            }
-          else if((y >= yA_) && (y < yD_))
-            {
-              xpoints[cnt_cross] = (int32_t)((((xD_-xA_)*(y-yA_))/(yD_-yA_))+xA_);
-              updowns[cnt_cross] = 0;
-            }
+          tmp  = x;
+          x    = maxx;
+          maxx = tmp;
+          a    = b;
         }
 
-      if(cnt_cross != 0)
-        {
-          if(xpoints[0] > xpoints[1])
-            {
-              xpoints[1] += xpoints[0];
-              xpoints[0]  = xpoints[1] - xpoints[0];
-              xpoints[1]  = xpoints[1] - xpoints[0];
-
-              tmp        = updowns[0];
-              updowns[0] = updowns[1];
-              updowns[1] = tmp;
-            }
-
-          if(cnt_cross > 2)
-            {
-              if(((CCBFLAGS & CCB_ACW)  && (updowns[2] == 0)) ||
-                 ((CCBFLAGS & CCB_ACCW) && (updowns[2] == 1)))
-                {
-                  x = xpoints[2];
-                  if(x < 0)
-                    x = 0;
-
-                  maxx = xpoints[3];
-                  if(maxx > maxxt)
-                    maxx = maxxt;
-
-                  for(; x < maxx; x++)
-                    {
-                      next = readPIX(x,y);
-                      if(next != curr)
-                        {
-                          curr  = next;
-                          pixel = PPROC(CURPIX_,next,LAMV_);
-                          pixel = PPROJ_OUTPUT(CURPIX_,pixel,next);
-                        }
-                      writePIX(x,y,pixel);
-                    }
-                }
-            }
-
-          if(((CCBFLAGS & CCB_ACW)  && (updowns[0] == 0)) ||
-             ((CCBFLAGS & CCB_ACCW) && (updowns[0] == 1)))
-            {
-              x = xpoints[0];
-              if(x < 0)
-                x = 0;
-
-              maxx = xpoints[1];
-              if(maxx > maxxt)
-                maxx = maxxt;
-
-              for(; x < maxx; x++)
-                {
-                  next = readPIX(x,y);
-                  if(next != curr)
-                    {
-                      curr  = next;
-                      pixel = PPROC(CURPIX_,next,LAMV_);
-                      pixel = PPROJ_OUTPUT(CURPIX_,pixel,next);
-                    }
-                  writePIX(x,y,pixel);
-                }
-            }
-        }
+      if(edges.match[a])
+        madam_arbitrary_span(ctx_,x,((maxx > maxxt) ? maxxt : maxx),
+                             y,CURPIX_,LAMV_,&curr,&pixel);
     }
 
   return 0;
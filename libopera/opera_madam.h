@@ -33,10 +33,45 @@
 
 #include "extern_c.h"
 
+#include <stdint.h>
+
 #define FSM_IDLE 1
 #define FSM_INPROCESS 2
 #define FSM_SUSPENDED 3
 
+#define OPERA_MADAM_CEL_PACKED    0
+#define OPERA_MADAM_CEL_LITERAL   1
+#define OPERA_MADAM_CEL_LR        2
+#define OPERA_MADAM_CEL_TYPES     3
+
+#define OPERA_MADAM_MAP_LINE      0
+#define OPERA_MADAM_MAP_SCALE     1
+#define OPERA_MADAM_MAP_ARBITRARY 2
+#define OPERA_MADAM_MAPS          3
+
+typedef uint64_t (*opera_madam_clock_t)(void);
+
+/*
+  Counts for the cels drawn since opera_madam_stats_reset(). Culled
+  cels face away or lie wholly off screen, clipped texels are those of
+  off screen rows and columns skipped without being decoded. ticks is
+  the time drawing each kind of cel by the clock passed to
+  opera_madam_stats_set(). With threaded MADAM texels are summed over
+  the bands which decode them.
+*/
+typedef struct opera_madam_stats_s opera_madam_stats_t;
+struct opera_madam_stats_s
+{
+  uint64_t cels;
+  uint64_t cels_skipped;
+  uint64_t cels_culled;
+  uint64_t texels;
+  uint64_t texels_transparent;
+  uint64_t texels_clipped;
+  uint64_t pixels;
+  uint64_t ticks[OPERA_MADAM_CEL_TYPES][OPERA_MADAM_MAPS];
+};
+
 EXTERN_C_BEGIN
 
 void      opera_madam_init(uint8_t *mem_);
@@ -46,6 +81,9 @@ uint32_t  opera_madam_fsm_get(void);
 void      opera_madam_fsm_set(uint32_t val_);
 
 void      opera_madam_cel_handle(void);
+void      opera_madam_cel_timing_set(const int enable_);
+int       opera_madam_cel_held(void);
+int32_t   opera_madam_cel_hold(const int32_t cycles_);
 
 uint32_t *opera_madam_registers(void);
 
@@ -56,6 +94,18 @@ void      opera_madam_kprint_enable(void);
 void      opera_madam_kprint_disable(void);
 void      opera_madam_me_mode_software(void);
 void      opera_madam_me_mode_hardware(void);
+void      opera_madam_threads_set(const uint32_t threads_);
+void      opera_madam_async_set(const int async_);
+void      opera_madam_sync(void);
+void      opera_madam_sync_range(const uint32_t addr_, const uint32_t len_);
+
+void      opera_madam_dram_dirty(const uint32_t addr_, const uint32_t len_);
+void      opera_madam_cel_cache_set(const int enable_);
+void      opera_madam_cel_cache_stats(uint64_t *hits_, uint64_t *misses_, uint64_t *rehashes_, uint64_t *bypasses_);
+void      opera_madam_cull_stats(uint64_t *rows_, uint64_t *texels_);
+void      opera_madam_stats_set(const int enable_, opera_madam_clock_t clock_);
+void      opera_madam_stats_get(opera_madam_stats_t *stats_);
+void      opera_madam_stats_reset(void);
 
 uint32_t  opera_madam_state_size(void);
 void      opera_madam_state_save(void *buf_);
@@ -29,7 +29,9 @@
 */
 
 #include "inline.h"
+#include "opera_arm.h"
 #include "opera_core.h"
+#include "opera_madam.h"
 
 #include <stdint.h>
 #include <string.h>
@@ -38,6 +40,7 @@
 #define SPORT_IDX_SHIFT  7
 #define SPORT_ELEM_COUNT 512
 #define SPORT_BUFSIZE    (SPORT_ELEM_COUNT * sizeof(uint32_t))
+#define SPORT_VRAM_ADDR  0x00200000
 
 struct sport_s
 {
@@ -112,6 +115,17 @@ sport_memcpy_highres(const uint32_t didx_,
   sport_memcpy(didx_ + (3*1024*1024/sizeof(uint32_t)),sidx_);
 }
 
+static
+INLINE
+void
+sport_invalidate(const uint32_t idx_)
+{
+  opera_arm_decode_cache_invalidate(SPORT_VRAM_ADDR + (idx_ * sizeof(uint32_t)),
+                                    SPORT_BUFSIZE);
+  opera_madam_dram_dirty(SPORT_VRAM_ADDR + (idx_ * sizeof(uint32_t)),
+                         SPORT_BUFSIZE);
+}
+
 static
 INLINE
 void
@@ -126,6 +140,8 @@ sport_flash_write(const uint32_t rawidx_,
   else
     sport_set_color_with_mask(idx,mask_);
 
+  sport_invalidate(idx);
+
   if(!HIRESMODE)
     return;
 
@@ -179,12 +195,17 @@ sport_copy_page(const uint32_t rawidx_,
     sport_copy_page_color();
   else
     sport_copy_page_color_with_mask(mask_);
+
+  sport_invalidate(SPORT.destination);
 }
 
 void
 opera_sport_write_access(const uint32_t idx_,
                           const uint32_t mask_)
 {
+  /* SPORT transfers write VRAM directly */
+  opera_madam_sync();
+
   switch(idx_ & 0x0000E000)
     {
     case 0x00000000:
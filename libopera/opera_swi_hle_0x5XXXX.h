@@ -80,12 +80,20 @@ opera_swi_hle_0x50002(void     *ram_,
 static
 INLINE
 void
-opera_swi_hle_0x50003(void    *ram_,
-                      uint8_t  r0_,
-                      uint8_t  r1_,
-                      uint8_t  r2_)
+opera_swi_hle_0x50003(void     *ram_,
+                      uint32_t  r0_,
+                      uint32_t  r1_,
+                      uint32_t  r2_)
 {
+  uint8_t    *ram;
+  ObjOffset1 *offsets;
+  int32_t     count;
+
+  ram     = ram_;
+  offsets = (ObjOffset1*)&ram[r1_];
+  count   = (int32_t)r2_;
 
+  MulObjectVec3Mat33_F16(ram,r0_,offsets,count);
 }
 
 /* void MulObjectMat33_F16(void *objectlist[], ObjOffset2 *offsetstruct, mat33f16 mat, int32 count); */
@@ -98,7 +106,17 @@ opera_swi_hle_0x50004(void     *ram_,
                       uint32_t  r2_,
                       uint32_t  r3_)
 {
+  uint8_t    *ram;
+  ObjOffset2 *offsets;
+  mat33f16   *mat;
+  int32_t     count;
 
+  ram     = ram_;
+  offsets = (ObjOffset2*)&ram[r1_];
+  mat     = (mat33f16*)&ram[r2_];
+  count   = (int32_t)r3_;
+
+  MulObjectMat33_F16(ram,r0_,offsets,*mat,count);
 }
 
 /* void MulManyF16(frac16 *dest, frac16 *src1, frac16 *src2, int32 count); */
@@ -229,7 +247,15 @@ opera_swi_hle_0x5000A(void     *ram_,
                       uint32_t  r1_,
                       uint32_t  r2_)
 {
+  uint8_t    *ram;
+  ObjOffset1 *offsets;
+  int32_t     count;
+
+  ram     = ram_;
+  offsets = (ObjOffset1*)&ram[r1_];
+  count   = (int32_t)r2_;
 
+  MulObjectVec4Mat44_F16(ram,r0_,offsets,count);
 }
 
 /* void MulObjectMat44_F16(void *objectlist[], ObjOffset2 *offsetstruct, mat44f16 mat, int32 count);  */
@@ -242,7 +268,17 @@ opera_swi_hle_0x5000B(void     *ram_,
                       uint32_t  r2_,
                       uint32_t  r3_)
 {
+  uint8_t    *ram;
+  ObjOffset2 *offsets;
+  mat44f16   *mat;
+  int32_t     count;
+
+  ram     = ram_;
+  offsets = (ObjOffset2*)&ram[r1_];
+  mat     = (mat44f16*)&ram[r2_];
+  count   = (int32_t)r3_;
 
+  MulObjectMat44_F16(ram,r0_,offsets,*mat,count);
 }
 
 /* frac16 Dot3_F16(vec3f16 v1, vec3f16 v2); */
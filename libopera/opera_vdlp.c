@@ -3,6 +3,7 @@
 
 #include "opera_arm.h"
 #include "opera_core.h"
+#include "opera_madam.h"
 #include "opera_region.h"
 #include "opera_vdl.h"
 #include "opera_vdlp.h"
@@ -18,6 +19,10 @@
   - add pseudo random 3bit pattern for second clut bypass mode
 */
 
+/* an entry is four words and up to 63 optional ones */
+#define VDLP_ENTRY_MAX  ((4 + 63) * sizeof(uint32_t))
+#define VDLP_LINE_BYTES (320 * sizeof(uint32_t))
+
 static vdlp_t   g_VDLP          = {0};
 static uint8_t *g_VRAM          = NULL;
 static void    *g_BUF           = NULL;
@@ -52,6 +57,16 @@ vdl_read(const uint32_t off_)
   return vram_read32(g_VDLP.curr_vdl + (off_ << 2));
 }
 
+/* wait for an async cel list drawing to the VRAM about to be read */
+static
+INLINE
+void
+vdlp_madam_sync(const uint32_t addr_,
+                const uint32_t len_)
+{
+  opera_madam_sync_range((0x200000 + (addr_ & 0x000FFFFF)),len_);
+}
+
 static
 void
 vdl_set_clut(const vdl_ctrl_word_u cmd_)
@@ -748,14 +763,21 @@ opera_vdlp_process_line(int line_)
     {
       g_CURBUF = g_BUF;
       g_VDLP.curr_vdl = g_VDLP.head_vdl;
+      vdlp_madam_sync(g_VDLP.curr_vdl,VDLP_ENTRY_MAX);
       vdlp_process_vdl_entry();
     }
 
   if(g_VDLP.line_cnt == 0)
-    vdlp_process_vdl_entry();
+    {
+      vdlp_madam_sync(g_VDLP.curr_vdl,VDLP_ENTRY_MAX);
+      vdlp_process_vdl_entry();
+    }
 
   if(visible_scanline(line_))
-    g_RENDERER();
+    {
+      vdlp_madam_sync(g_VDLP.curr_bmp,VDLP_LINE_BYTES);
+      g_RENDERER();
+    }
 
   g_VDLP.prev_bmp = ((g_VDLP.clut_ctrl.cdcw.prev_fba_tick) ?
                      tick_fba(g_VDLP.prev_bmp) : g_VDLP.curr_bmp);
@@ -42,6 +42,7 @@ static uint32_t             ACTIVE_DEVICES;
 static int                  g_PIXEL_FORMAT_SET  = false;
 static vdlp_pixel_format_e  g_VDLP_PIXEL_FORMAT = VDLP_PIXEL_FORMAT_XRGB8888;
 static uint32_t             g_VDLP_FLAGS        = VDLP_FLAG_NONE;
+static bool                 g_MADAM_STATS       = false;
 static const opera_bios_t *BIOS = NULL;
 static const opera_bios_t *FONT = NULL;
 
@@ -489,6 +490,47 @@ chkopt_madam_matrix_engine(void)
     opera_madam_me_mode_hardware();
 }
 
+static
+void
+chkopt_madam_cel_cache(void)
+{
+  bool rv;
+
+  rv = chkopt_is_enabled("madam_cel_cache");
+
+  opera_madam_cel_cache_set(rv);
+}
+
+static
+void
+chkopt_madam_cel_timing(void)
+{
+  bool rv;
+
+  rv = chkopt_is_enabled("madam_cel_timing");
+
+  opera_madam_cel_timing_set(rv);
+}
+
+/* the cel engine is timed by the frontend's CPU counter when it has one */
+static
+void
+chkopt_madam_stats(void)
+{
+  bool rv;
+  struct retro_perf_callback perf;
+
+  rv = chkopt_is_enabled("madam_stats");
+
+  memset(&perf,0,sizeof(perf));
+  if(rv)
+    retro_environment_cb(RETRO_ENVIRONMENT_GET_PERF_INTERFACE,&perf);
+
+  opera_madam_stats_set(rv,perf.get_perf_counter);
+
+  g_MADAM_STATS = rv;
+}
+
 static
 void
 chkopt_kprint(void)
@@ -514,6 +556,32 @@ chkopt_dsp_threaded(void)
   lr_dsp_init(rv);
 }
 
+#if THREADED_MADAM
+static
+void
+chkopt_madam_threads(void)
+{
+  const char *val;
+
+  val = chkopt_getval("madam_threads");
+  if(val == NULL)
+    return;
+
+  opera_madam_threads_set(atoi(val));
+}
+
+static
+void
+chkopt_madam_async(void)
+{
+  bool rv;
+
+  rv = chkopt_is_enabled("madam_async");
+
+  opera_madam_async_set(rv);
+}
+#endif
+
 static
 void
 chkopt_swi_hle(void)
@@ -525,6 +593,160 @@ chkopt_swi_hle(void)
   opera_arm_swi_hle_set(rv);
 }
 
+static
+void
+chkopt_dynarec(void)
+{
+  bool rv;
+
+  rv = chkopt_is_enabled("dynarec");
+
+  opera_arm_dynarec_set(rv);
+}
+
+static
+void
+chkopt_idle_skip(void)
+{
+  bool rv;
+
+  rv = chkopt_is_enabled("idle_skip");
+
+  opera_arm_idle_set(rv);
+}
+
+static
+void
+swi_hle_log_hits(void)
+{
+  uint32_t n;
+  uint32_t swi;
+  uint64_t hits;
+
+  for(n = 0; opera_arm_swi_hle_stats(n,&swi,&hits); n++)
+    {
+      if(hits == 0)
+        continue;
+      retro_log_printf_cb(RETRO_LOG_INFO,
+                          "[Opera]: SWI 0x%05X handled by HLE %llu times\n",
+                          swi,
+                          (unsigned long long)hits);
+    }
+}
+
+/*
+  MADAM statistics are summed over about a second of frames and
+  logged as per frame averages, times as each kind of cel's share.
+*/
+static
+void
+madam_stats_log(void)
+{
+  static opera_madam_stats_t sum;
+  static uint32_t frames = 0;
+  uint32_t i;
+  uint32_t j;
+  uint64_t ticks;
+  opera_madam_stats_t stats;
+  static const char *types[OPERA_MADAM_CEL_TYPES] = {"packed","literal","LR"};
+
+  opera_madam_stats_get(&stats);
+
+  sum.cels               += stats.cels;
+  sum.cels_skipped       += stats.cels_skipped;
+  sum.cels_culled        += stats.cels_culled;
+  sum.texels             += stats.texels;
+  sum.texels_transparent += stats.texels_transparent;
+  sum.texels_clipped     += stats.texels_clipped;
+  sum.pixels             += stats.pixels;
+  for(i = 0; i < OPERA_MADAM_CEL_TYPES; i++)
+    for(j = 0; j < OPERA_MADAM_MAPS; j++)
+      sum.ticks[i][j] += stats.ticks[i][j];
+
+  if(++frames < (uint32_t)opera_region_field_rate())
+    return;
+
+  retro_log_printf_cb(RETRO_LOG_INFO,
+                      "[Opera]: MADAM per frame: %llu cels, %llu skipped, %llu culled,"
+                      " %llu texels, %llu transparent, %llu clipped, %llu pixels\n",
+                      (unsigned long long)(sum.cels / frames),
+                      (unsigned long long)(sum.cels_skipped / frames),
+                      (unsigned long long)(sum.cels_culled / frames),
+                      (unsigned long long)(sum.texels / frames),
+                      (unsigned long long)(sum.texels_transparent / frames),
+                      (unsigned long long)(sum.texels_clipped / frames),
+                      (unsigned long long)(sum.pixels / frames));
+
+  ticks = 0;
+  for(i = 0; i < OPERA_MADAM_CEL_TYPES; i++)
+    for(j = 0; j < OPERA_MADAM_MAPS; j++)
+      ticks += sum.ticks[i][j];
+
+  if(ticks)
+    {
+      for(i = 0; i < OPERA_MADAM_CEL_TYPES; i++)
+        retro_log_printf_cb(RETRO_LOG_INFO,
+                            "[Opera]: MADAM %s cels: line %.1f%%, scale %.1f%%, arbitrary %.1f%% of %llu ticks per frame\n",
+                            types[i],
+                            (100.0 * sum.ticks[i][OPERA_MADAM_MAP_LINE]) / ticks,
+                            (100.0 * sum.ticks[i][OPERA_MADAM_MAP_SCALE]) / ticks,
+                            (100.0 * sum.ticks[i][OPERA_MADAM_MAP_ARBITRARY]) / ticks,
+                            (unsigned long long)(ticks / frames));
+    }
+
+  memset(&sum,0,sizeof(sum));
+  frames = 0;
+}
+
+/*
+  The profile is written to the system directory next to the shared
+  NVRAM, there may be no content specific directory.
+*/
+static
+void
+arm_profile_dump(void)
+{
+  int rv;
+  const char *basepath;
+  char fullpath[PATH_MAX_LENGTH];
+
+  if(!opera_arm_profile_enabled())
+    return;
+
+  basepath = NULL;
+  rv = retro_environment_cb(RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY,&basepath);
+  if((rv == 0) || (basepath == NULL))
+    return;
+
+  fill_pathname_join(fullpath,basepath,"opera_arm_profile.txt",sizeof(fullpath));
+
+  rv = opera_arm_profile_dump(fullpath);
+  if(rv == 0)
+    retro_log_printf_cb(RETRO_LOG_INFO,"[Opera]: wrote ARM profile to %s\n",fullpath);
+  else
+    retro_log_printf_cb(RETRO_LOG_ERROR,"[Opera]: unable to write %s\n",fullpath);
+
+  opera_arm_profile_reset();
+}
+
+/* dump the profile collected so far each time the option is enabled */
+static
+void
+chkopt_arm_profile(void)
+{
+  static int prev = -1;
+  int rv;
+
+  if(!opera_arm_profile_enabled())
+    return;
+
+  rv = chkopt_is_enabled("arm_profile_dump");
+  if(rv && (prev == 0))
+    arm_profile_dump();
+
+  prev = rv;
+}
+
 static
 void
 chkopts(void)
@@ -540,7 +762,17 @@ chkopts(void)
   chkopt_active_devices();
   chkopt_kprint();
   chkopt_madam_matrix_engine();
+  chkopt_madam_cel_cache();
+  chkopt_madam_cel_timing();
+  chkopt_madam_stats();
+#if THREADED_MADAM
+  chkopt_madam_threads();
+  chkopt_madam_async();
+#endif
   chkopt_swi_hle();
+  chkopt_dynarec();
+  chkopt_idle_skip();
+  chkopt_arm_profile();
   chkopt_set_reset_bits("hack_timing_1",&FIXMODE,FIX_BIT_TIMING_1);
   chkopt_set_reset_bits("hack_timing_3",&FIXMODE,FIX_BIT_TIMING_3);
   chkopt_set_reset_bits("hack_timing_5",&FIXMODE,FIX_BIT_TIMING_5);
@@ -766,10 +998,47 @@ retro_load_game_special(unsigned                      game_type_,
 void
 retro_unload_game(void)
 {
+  uint64_t locks;
+  uint64_t skipped;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t rehashes;
+  uint64_t bypasses;
+  uint64_t rows;
+  uint64_t texels;
+
   if(chkopt_nvram_shared())
     retro_nvram_save(opera_arm_nvram_get());
 
+  opera_arm_idle_stats(&locks,&skipped);
+  if(skipped)
+    retro_log_printf_cb(RETRO_LOG_INFO,
+                        "[Opera]: skipped %llu idle CPU cycles in %llu loops\n",
+                        (unsigned long long)skipped,
+                        (unsigned long long)locks);
+
+  opera_madam_cel_cache_stats(&hits,&misses,&rehashes,&bypasses);
+  if(hits || misses)
+    retro_log_printf_cb(RETRO_LOG_INFO,
+                        "[Opera]: cel cache %llu hits, %llu misses, %llu rehashes, %llu bypassed\n",
+                        (unsigned long long)hits,
+                        (unsigned long long)misses,
+                        (unsigned long long)rehashes,
+                        (unsigned long long)bypasses);
+
+  opera_madam_cull_stats(&rows,&texels);
+  if(rows || texels)
+    retro_log_printf_cb(RETRO_LOG_INFO,
+                        "[Opera]: culled %llu cel rows and %llu texels off screen\n",
+                        (unsigned long long)rows,
+                        (unsigned long long)texels);
+
+  swi_hle_log_hits();
+  arm_profile_dump();
+
   lr_dsp_destroy();
+  opera_madam_async_set(0);
+  opera_madam_threads_set(1);
   opera_3do_destroy();
 
   retro_cdimage_close(&CDIMAGE);
@@ -907,6 +1176,9 @@ retro_run(void)
 
   opera_3do_process_frame();
 
+  if(g_MADAM_STATS)
+    madam_stats_log();
+
   lr_input_crosshairs_draw(g_VIDEO_BUFFER,g_VIDEO_WIDTH,g_VIDEO_HEIGHT);
 
   lr_dsp_upload();
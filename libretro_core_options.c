@@ -117,6 +117,39 @@ static struct retro_core_option_definition option_defs_us[] =
       },
       "hardware"
     },
+    {
+      "opera_madam_cel_cache",
+      "MADAM Cel Cache",
+      "Keep decoded packed cels, such as fonts, HUD elements and tiles, and draw them again without decoding them while their data and palette are unchanged. Improves performance in games which draw the same packed cels every frame.",
+      {
+        { "disabled", NULL },
+        { "enabled",  NULL },
+        { NULL, NULL },
+      },
+      "disabled"
+    },
+    {
+      "opera_madam_cel_timing",
+      "MADAM Cel Engine Timing",
+      "Give the cel engine's drawing time, holding the CPU off while it draws as the hardware does, rather than drawing each cel list at once. Long cel lists are spread over the frame and into the next, which smooths frame times in games that draw large lists. The time is estimated and may change the speed of some games.",
+      {
+        { "disabled", NULL },
+        { "enabled",  NULL },
+        { NULL, NULL },
+      },
+      "disabled"
+    },
+    {
+      "opera_madam_stats",
+      "MADAM Statistics",
+      "Log the number of cels, texels and pixels MADAM processes per frame, and how its time splits between kinds of cels, averaged over each second. For developers; slightly reduces performance.",
+      {
+        { "disabled", NULL },
+        { "enabled",  NULL },
+        { NULL, NULL },
+      },
+      "disabled"
+    },
     {
       "opera_swi_hle",
       "OperaOS SWI HLE",
@@ -128,6 +161,43 @@ static struct retro_core_option_definition option_defs_us[] =
       },
       "disabled"
     },
+    {
+      "opera_idle_skip",
+      "Skip CPU Idle Loops",
+      "Detect loops in which the CPU only polls memory or hardware registers waiting for an interrupt and skip ahead to the next timer, audio or video event instead of executing them. Emulation is unchanged but host CPU usage, and so power draw, drops while games wait.",
+      {
+        { "disabled", NULL },
+        { "enabled",  NULL },
+        { NULL, NULL },
+      },
+      "disabled"
+    },
+#if defined(HAVE_DYNAREC) && defined(__x86_64__)
+    {
+      "opera_dynarec",
+      "CPU Dynamic Recompiler",
+      "Translate ARM60 code into native x86-64 code instead of interpreting it. Greatly reduces the host CPU needed, especially with overclocking. Falls back to the interpreter where executable memory is not available. !EXPERIMENTAL!",
+      {
+        { "disabled", NULL },
+        { "enabled",  NULL },
+        { NULL, NULL },
+      },
+      "disabled"
+    },
+#endif
+#ifdef ARM_PROFILER
+    {
+      "opera_arm_profile_dump",
+      "Dump ARM Profile",
+      "Write the cycles the CPU spent per ROM and DRAM address, per OS call and in skipped idle loops since the last dump to opera_arm_profile.txt in the system directory each time this is enabled. The profile is also written when content is closed.",
+      {
+        { "disabled", NULL },
+        { "enabled",  NULL },
+        { NULL, NULL },
+      },
+      "disabled"
+    },
+#endif
 #if THREADED_DSP
     {
       "opera_dsp_threaded",
@@ -140,6 +210,34 @@ static struct retro_core_option_definition option_defs_us[] =
       },
       "disabled"
     },
+#endif
+#if THREADED_MADAM
+    {
+      "opera_madam_threads",
+      "MADAM Threads",
+      "Number of CPU threads the cel engine splits the framebuffer between. Cels which blend with the framebuffer are split too; only cels whose image data lies inside the framebuffer being drawn to are drawn on their own. !EXPERIMENTAL!",
+      {
+        { "1", NULL },
+        { "2", NULL },
+        { "3", NULL },
+        { "4", NULL },
+        { "6", NULL },
+        { "8", NULL },
+        { NULL, NULL },
+      },
+      "1"
+    },
+    {
+      "opera_madam_async",
+      "MADAM Async Cel Engine",
+      "Draws cel lists on a separate thread while the CPU continues. The CPU waits when it touches the framebuffer being drawn or the cel data being read. !EXPERIMENTAL!",
+      {
+        { "disabled", NULL },
+        { "enabled",  NULL },
+        { NULL, NULL },
+      },
+      "disabled"
+    },
 #endif
     {
       "opera_nvram_storage",